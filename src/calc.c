@@ -13,24 +13,40 @@
 #include "parser.h"
 #include <ctype.h>
 #include "memory.h"
+#include "intern.h"
+#include "reader.h"
+#include "pool.h"
 
 /**
  * Główna cześć programu, wczytuje linie i wykonuje polecenia.
  */
 int main() {
-    ssize_t line_length = 0;
-    size_t size = 0;
-    char *curr_line = NULL;
-    int line = 0;
+    ReaderLine curr_line;
+    size_t line = 0;
     Stack s = NewStack();
+    //Zmienna środowiskowa POLY_ARENA włącza budowanie wyników operacji w arenach.
+    s.use_arenas = getenv("POLY_ARENA") != NULL;
+    //Zmienna środowiskowa POLY_INTERN włącza sprowadzanie elementów stosu do postaci kanonicznej.
+    s.intern = getenv("POLY_INTERN") != NULL;
+    //Zmienna środowiskowa POLY_LAZY włącza odkładanie operacji do czasu, gdy potrzebny jest wynik.
+    s.lazy = getenv("POLY_LAZY") != NULL;
+    //Zmienna środowiskowa POLY_THREADS ustawia liczbę wątków mnożących wielomiany; 0 to liczba procesorów.
+    if (getenv("POLY_THREADS") != NULL)
+        PoolSetThreads(strtoul(getenv("POLY_THREADS"), NULL, 10));
 
-    while ((line_length = SafeGetLine(&curr_line, &size, stdin)) != -1) {
+    //Zmienna środowiskowa POLY_MMAP włącza odwzorowanie w pamięci wejścia będącego zwykłym plikiem.
+    Reader reader;
+    ReaderOpen(&reader, 0, getenv("POLY_MMAP") != NULL);
+    while (ReaderNext(&reader, &curr_line)) {
         line++;
-        LineInterpreter(curr_line, line, line_length, &s);
+        LineInterpreter(curr_line.text, line, curr_line.length, curr_line.has_nul, &s);
     }
 
     StackDestroy(&s);
-    free(curr_line);
+    PoolShutdown();
+    PolyInternRelease();
+    BlockPoolRelease();
+    ReaderClose(&reader);
 
     return 0;
 
@@ -0,0 +1,28 @@
+/** @file
+  Interfejs wewnętrznej funkcji przywracającej postać kanoniczną wielomianu.
+
+  Moduły, które same wypełniają tablice jednomianów, kończą je tą funkcją,
+  żeby postać kanoniczna była ustalona w jednym miejscu.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef CANON_H
+#define CANON_H
+
+#include "poly.h"
+
+/**
+ * Tworzy wielomian z tablicy jednomianów o rosnących wykładnikach
+ * i niezerowych współczynnikach, przywracając postać kanoniczną.
+ * Przejmuje tablicę na własność: pustą zwalnia i zwraca zero, a jedyny
+ * jednomian o wykładniku zero i współczynniku liczbowym zamienia na ten współczynnik.
+ * @param[in] arr : tablica jednomianów zaalokowana funkcją BlockAlloc
+ * @param[in] size : liczba jednomianów
+ * @return wielomian
+ */
+Poly PolyFinish(Mono *arr, size_t size);
+
+#endif //CANON_H
@@ -0,0 +1,368 @@
+/** @file
+  Implementacja rozproszonej reprezentacji wielomianów.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <stdlib.h>
+#include "dist.h"
+#include "memory.h"
+#include "canon.h"
+
+/** Liczba bitów w słowie klucza. */
+#define DIST_WORD_BITS 64
+
+/**
+ * Zwraca liczbę pól wykładników mieszczących się w jednym słowie klucza.
+ * @param[in] bits : liczba bitów pola
+ * @return liczba pól w słowie
+ */
+static size_t FieldsPerWord(unsigned bits) {
+    return DIST_WORD_BITS / bits;
+}
+
+/**
+ * Sprawdza, czy wykładniki zadanej liczby zmiennych mieszczą się w kluczu.
+ * @param[in] vars : liczba zmiennych
+ * @param[in] bits : liczba bitów pola
+ * @return czy wektor wykładników mieści się w dwóch słowach
+ */
+static bool LayoutFits(size_t vars, unsigned bits) {
+    return vars <= 2 * FieldsPerWord(bits);
+}
+
+/**
+ * Zwraca przesunięcie pola zmiennej w jej słowie.
+ * @param[in] bits : liczba bitów pola
+ * @param[in] var : indeks zmiennej
+ * @return przesunięcie pola
+ */
+static unsigned FieldShift(unsigned bits, size_t var) {
+    size_t per_word = FieldsPerWord(bits);
+    return (unsigned) ((per_word - 1 - var % per_word) * bits);
+}
+
+/**
+ * Sprawdza, czy pole zmiennej leży w starszym słowie klucza.
+ * @param[in] bits : liczba bitów pola
+ * @param[in] var : indeks zmiennej
+ * @return czy pole leży w starszym słowie
+ */
+static bool FieldInHi(unsigned bits, size_t var) {
+    return var < FieldsPerWord(bits);
+}
+
+/**
+ * Odczytuje wykładnik zmiennej z klucza.
+ * @param[in] bits : liczba bitów pola
+ * @param[in] key : klucz
+ * @param[in] var : indeks zmiennej
+ * @return wykładnik
+ */
+static poly_exp_t FieldGet(unsigned bits, DistKey key, size_t var) {
+    unsigned long word = FieldInHi(bits, var) ? key.hi : key.lo;
+    unsigned long mask = (1UL << bits) - 1;
+    return (poly_exp_t) ((word >> FieldShift(bits, var)) & mask);
+}
+
+/**
+ * Zapisuje wykładnik zmiennej w kluczu, w którym to pole jest zerowe.
+ * @param[in] bits : liczba bitów pola
+ * @param[in,out] key : klucz
+ * @param[in] var : indeks zmiennej
+ * @param[in] exp : wykładnik
+ */
+static void FieldSet(unsigned bits, DistKey *key, size_t var, poly_exp_t exp) {
+    unsigned long field = (unsigned long) exp << FieldShift(bits, var);
+    if (FieldInHi(bits, var))
+        key->hi |= field;
+    else
+        key->lo |= field;
+}
+
+/**
+ * Porównuje klucze jako liczby 128-bitowe.
+ * @param[in] a : klucz
+ * @param[in] b : klucz
+ * @return liczba ujemna, zero lub liczba dodatnia, jeśli pierwszy klucz jest odpowiednio mniejszy, równy lub większy
+ */
+static int KeyCmp(DistKey a, DistKey b) {
+    if (a.hi != b.hi)
+        return a.hi < b.hi ? -1 : 1;
+    return (a.lo > b.lo) - (a.lo < b.lo);
+}
+
+/**
+ * Zwraca najmniejszą liczbę bitów potrzebną do zapisania wykładnika.
+ * @param[in] exp : wykładnik
+ * @return liczba bitów, co najmniej 1
+ */
+static unsigned BitsFor(poly_exp_t exp) {
+    unsigned bits = 1;
+    while (bits < DIST_WORD_BITS && ((unsigned long) exp >> bits) != 0)
+        bits++;
+    return bits;
+}
+
+/**
+ * Tworzy reprezentację rozproszoną o zadanej pojemności i układzie pól.
+ * @param[in] capacity : liczba miejsc na wyrazy
+ * @param[in] vars : liczba zmiennych
+ * @param[in] bits : liczba bitów pola
+ * @return reprezentacja bez wyrazów
+ */
+static DistPoly DistNew(size_t capacity, size_t vars, unsigned bits) {
+    return (DistPoly) {
+        .size = 0,
+        .vars = vars,
+        .bits = bits,
+        .keys = (DistKey *) SafeMalloc((capacity + 1) * sizeof(DistKey)),
+        .coeffs = (poly_coeff_t *) SafeMalloc((capacity + 1) * sizeof(poly_coeff_t))
+    };
+}
+
+/**
+ * Zlicza wyrazy wielomianu i wyznacza liczbę zmiennych oraz największy wykładnik.
+ * @param[in] p : wielomian zmiennych od @p depth wzwyż
+ * @param[in] depth : indeks zmiennej głównej wielomianu @p p
+ * @param[in,out] vars : liczba zmiennych
+ * @param[in,out] max_exp : największy wykładnik
+ * @param[in,out] terms : liczba wyrazów
+ */
+static void Scan(const Poly *p, size_t depth, size_t *vars, poly_exp_t *max_exp, size_t *terms) {
+    if (PolyIsCoeff(p)) {
+        if (p->coeff != 0) {
+            (*terms)++;
+            if (depth > *vars)
+                *vars = depth;
+        }
+        return;
+    }
+    for (size_t i = 0; i < p->size; i++) {
+        if (p->arr[i].exp > *max_exp)
+            *max_exp = p->arr[i].exp;
+        Scan(&p->arr[i].p, depth + 1, vars, max_exp, terms);
+    }
+}
+
+/**
+ * Dopisuje wyrazy wielomianu do reprezentacji rozproszonej w porządku drzewa,
+ * który jest porządkiem kluczy.
+ * @param[in] p : wielomian zmiennych od @p depth wzwyż
+ * @param[in] depth : indeks zmiennej głównej wielomianu @p p
+ * @param[in] prefix : klucz z wykładnikami zmiennych o indeksach mniejszych niż @p depth
+ * @param[in,out] d : reprezentacja rozproszona
+ */
+static void Fill(const Poly *p, size_t depth, DistKey prefix, DistPoly *d) {
+    if (PolyIsCoeff(p)) {
+        if (p->coeff != 0) {
+            d->keys[d->size] = prefix;
+            d->coeffs[d->size++] = p->coeff;
+        }
+        return;
+    }
+    for (size_t i = 0; i < p->size; i++) {
+        DistKey key = prefix;
+        FieldSet(d->bits, &key, depth, p->arr[i].exp);
+        Fill(&p->arr[i].p, depth + 1, key, d);
+    }
+}
+
+bool DistFromPoly(const Poly *p, DistPoly *d) {
+    assert(p != NULL && d != NULL);
+    size_t vars = 0, terms = 0;
+    poly_exp_t max_exp = 0;
+    Scan(p, 0, &vars, &max_exp, &terms);
+
+    unsigned bits = BitsFor(max_exp);
+    if (!LayoutFits(vars, bits)) {
+        *d = (DistPoly) {.size = 0, .vars = vars, .bits = bits, .keys = NULL, .coeffs = NULL};
+        return false;
+    }
+    *d = DistNew(terms, vars, bits);
+    Fill(p, 0, (DistKey) {.hi = 0, .lo = 0}, d);
+    return true;
+}
+
+/**
+ * Tworzy wielomian z przedziału wyrazów o wspólnych wykładnikach zmiennych
+ * o indeksach mniejszych niż @p var.
+ * @param[in] d : reprezentacja rozproszona
+ * @param[in] from : indeks pierwszego wyrazu
+ * @param[in] to : indeks za ostatnim wyrazem
+ * @param[in] var : indeks zmiennej głównej tworzonego wielomianu
+ * @return wielomian
+ */
+static Poly Build(const DistPoly *d, size_t from, size_t to, size_t var) {
+    if (var == d->vars)
+        return PolyFromCoeff(d->coeffs[from]);
+
+    size_t groups = 1;
+    for (size_t i = from + 1; i < to; i++) {
+        if (FieldGet(d->bits, d->keys[i], var) != FieldGet(d->bits, d->keys[i - 1], var))
+            groups++;
+    }
+
+    Mono *arr = (Mono *) BlockAlloc(groups * sizeof(Mono));
+    size_t size = 0, start = from;
+    for (size_t i = from + 1; i <= to; i++) {
+        poly_exp_t exp = FieldGet(d->bits, d->keys[start], var);
+        if (i == to || FieldGet(d->bits, d->keys[i], var) != exp) {
+            arr[size].p = Build(d, start, i, var + 1);
+            arr[size++].exp = exp;
+            start = i;
+        }
+    }
+
+    return PolyFinish(arr, size);
+}
+
+Poly DistToPoly(const DistPoly *d) {
+    assert(d != NULL);
+    if (d->size == 0)
+        return PolyZero();
+    return Build(d, 0, d->size, 0);
+}
+
+/**
+ * Przepisuje reprezentację rozproszoną na układ z większą liczbą zmiennych
+ * lub szerszymi polami. Porządek wyrazów się nie zmienia.
+ * @param[in] d : reprezentacja rozproszona
+ * @param[in] vars : liczba zmiennych, nie mniejsza niż w @p d
+ * @param[in] bits : liczba bitów pola, nie mniejsza niż w @p d
+ * @return reprezentacja w nowym układzie
+ */
+static DistPoly Repack(const DistPoly *d, size_t vars, unsigned bits) {
+    DistPoly result = DistNew(d->size, vars, bits);
+    for (size_t i = 0; i < d->size; i++) {
+        DistKey key = {.hi = 0, .lo = 0};
+        for (size_t v = 0; v < d->vars; v++)
+            FieldSet(bits, &key, v, FieldGet(d->bits, d->keys[i], v));
+        result.keys[i] = key;
+        result.coeffs[i] = d->coeffs[i];
+    }
+    result.size = d->size;
+    return result;
+}
+
+bool DistAdd(const DistPoly *a, const DistPoly *b, DistPoly *result) {
+    assert(a != NULL && b != NULL && result != NULL);
+    size_t vars = a->vars > b->vars ? a->vars : b->vars;
+    unsigned bits = a->bits > b->bits ? a->bits : b->bits;
+    if (!LayoutFits(vars, bits)) {
+        *result = (DistPoly) {.size = 0, .vars = vars, .bits = bits, .keys = NULL, .coeffs = NULL};
+        return false;
+    }
+
+    //Składniki w innym układzie pól przepisujemy, żeby scalać same klucze.
+    DistPoly a_packed, b_packed;
+    bool a_repacked = a->vars != vars || a->bits != bits;
+    bool b_repacked = b->vars != vars || b->bits != bits;
+    if (a_repacked) {
+        a_packed = Repack(a, vars, bits);
+        a = &a_packed;
+    }
+    if (b_repacked) {
+        b_packed = Repack(b, vars, bits);
+        b = &b_packed;
+    }
+
+    *result = DistNew(a->size + b->size, vars, bits);
+    size_t size = 0, i = 0, j = 0;
+    while (i < a->size && j < b->size) {
+        int cmp = KeyCmp(a->keys[i], b->keys[j]);
+        if (cmp < 0) {
+            result->keys[size] = a->keys[i];
+            result->coeffs[size++] = a->coeffs[i++];
+        } else if (cmp > 0) {
+            result->keys[size] = b->keys[j];
+            result->coeffs[size++] = b->coeffs[j++];
+        } else {
+            unsigned long sum = (unsigned long) a->coeffs[i] + (unsigned long) b->coeffs[j];
+            if (sum != 0) {
+                result->keys[size] = a->keys[i];
+                result->coeffs[size++] = (poly_coeff_t) sum;
+            }
+            i++;
+            j++;
+        }
+    }
+    for (; i < a->size; i++) {
+        result->keys[size] = a->keys[i];
+        result->coeffs[size++] = a->coeffs[i];
+    }
+    for (; j < b->size; j++) {
+        result->keys[size] = b->keys[j];
+        result->coeffs[size++] = b->coeffs[j];
+    }
+    result->size = size;
+
+    if (a_repacked)
+        DistDestroy(&a_packed);
+    if (b_repacked)
+        DistDestroy(&b_packed);
+    return true;
+}
+
+poly_exp_t DistDeg(const DistPoly *d) {
+    assert(d != NULL);
+    if (d->size == 0)
+        return -1;
+
+    //Sumy wykładników liczymy zmienna po zmiennej, żeby pętle po wyrazach
+    //nie miały rozgałęzień i dały się zwektoryzować.
+    unsigned long *total = (unsigned long *) SafeCalloc(d->size, sizeof(unsigned long));
+    unsigned long mask = (1UL << d->bits) - 1;
+    for (size_t v = 0; v < d->vars; v++) {
+        unsigned shift = FieldShift(d->bits, v);
+        if (FieldInHi(d->bits, v)) {
+            for (size_t i = 0; i < d->size; i++)
+                total[i] += (d->keys[i].hi >> shift) & mask;
+        } else {
+            for (size_t i = 0; i < d->size; i++)
+                total[i] += (d->keys[i].lo >> shift) & mask;
+        }
+    }
+
+    unsigned long deg = 0;
+    for (size_t i = 0; i < d->size; i++)
+        deg = total[i] > deg ? total[i] : deg;
+    free(total);
+    return (poly_exp_t) deg;
+}
+
+poly_exp_t DistDegBy(const DistPoly *d, size_t var_idx) {
+    assert(d != NULL);
+    if (d->size == 0)
+        return -1;
+    if (var_idx >= d->vars)
+        return 0;
+    //Wyrazy są posortowane względem wykładnika pierwszej zmiennej.
+    if (var_idx == 0)
+        return FieldGet(d->bits, d->keys[d->size - 1], 0);
+
+    unsigned long mask = (1UL << d->bits) - 1, deg = 0;
+    unsigned shift = FieldShift(d->bits, var_idx);
+    if (FieldInHi(d->bits, var_idx)) {
+        for (size_t i = 0; i < d->size; i++) {
+            unsigned long exp = (d->keys[i].hi >> shift) & mask;
+            deg = exp > deg ? exp : deg;
+        }
+    } else {
+        for (size_t i = 0; i < d->size; i++) {
+            unsigned long exp = (d->keys[i].lo >> shift) & mask;
+            deg = exp > deg ? exp : deg;
+        }
+    }
+    return (poly_exp_t) deg;
+}
+
+void DistDestroy(DistPoly *d) {
+    free(d->keys);
+    free(d->coeffs);
+    d->keys = NULL;
+    d->coeffs = NULL;
+    d->size = 0;
+}
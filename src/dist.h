@@ -0,0 +1,89 @@
+/** @file
+  Interfejs rozproszonej reprezentacji wielomianów.
+
+  Wielomian w reprezentacji rozproszonej to tablica wyrazów: współczynnik
+  i wektor wykładników wszystkich zmiennych spakowany w klucz złożony z dwóch
+  słów 64-bitowych. Każda zmienna zajmuje pole o tej samej liczbie bitów,
+  a zmienna @f$x_0@f$ leży w najstarszych bitach, więc porządek kluczy jako
+  liczb jest porządkiem leksykograficznym jednomianów, tym samym, w którym
+  jednomiany występują w rekurencyjnej reprezentacji Poly. Jeśli wszystkie
+  pola mieszczą się w pierwszym słowie, drugie słowo jest zerowe.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef DIST_H
+#define DIST_H
+
+#include "poly.h"
+
+/**
+ * To jest struktura przechowująca spakowany wektor wykładników.
+ */
+typedef struct DistKey {
+    unsigned long hi; ///< starsze słowo
+    unsigned long lo; ///< młodsze słowo
+} DistKey;
+
+/**
+ * To jest struktura przechowująca wielomian w reprezentacji rozproszonej.
+ * Wyrazy są posortowane rosnąco względem kluczy i mają niezerowe współczynniki.
+ */
+typedef struct DistPoly {
+    size_t size; ///< liczba wyrazów
+    size_t vars; ///< liczba zmiennych
+    unsigned bits; ///< liczba bitów pola wykładnika jednej zmiennej
+    DistKey *keys; ///< spakowane wektory wykładników
+    poly_coeff_t *coeffs; ///< współczynniki
+} DistPoly;
+
+/**
+ * Tworzy rozproszoną reprezentację wielomianu.
+ * @param[in] p : wielomian
+ * @param[out] d : reprezentacja rozproszona
+ * @return czy wektory wykładników mieszczą się w dwóch słowach
+ */
+bool DistFromPoly(const Poly *p, DistPoly *d);
+
+/**
+ * Tworzy wielomian z reprezentacji rozproszonej.
+ * @param[in] d : reprezentacja rozproszona
+ * @return wielomian
+ */
+Poly DistToPoly(const DistPoly *d);
+
+/**
+ * Dodaje dwa wielomiany w reprezentacji rozproszonej, scalając ich wyrazy.
+ * Jeśli czynniki mają różne rozmiary pól, wynik ma większe pola.
+ * @param[in] a : wielomian @f$a@f$
+ * @param[in] b : wielomian @f$b@f$
+ * @param[out] result : @f$a + b@f$
+ * @return czy wektory wykładników wyniku mieszczą się w dwóch słowach
+ */
+bool DistAdd(const DistPoly *a, const DistPoly *b, DistPoly *result);
+
+/**
+ * Zwraca stopień wielomianu w reprezentacji rozproszonej, tak jak PolyDeg.
+ * @param[in] d : wielomian
+ * @return stopień wielomianu
+ */
+poly_exp_t DistDeg(const DistPoly *d);
+
+/**
+ * Zwraca stopień wielomianu w reprezentacji rozproszonej ze względu na zadaną
+ * zmienną, tak jak PolyDegBy.
+ * @param[in] d : wielomian
+ * @param[in] var_idx : indeks zmiennej
+ * @return stopień wielomianu ze względu na zmienną
+ */
+poly_exp_t DistDegBy(const DistPoly *d, size_t var_idx);
+
+/**
+ * Zwalnia pamięć wielomianu w reprezentacji rozproszonej.
+ * @param[in] d : wielomian
+ */
+void DistDestroy(DistPoly *d);
+
+#endif //DIST_H
@@ -0,0 +1,173 @@
+/** @file
+  Implementacja tablicy wielomianów w postaci kanonicznej.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "intern.h"
+#include "memory.h"
+
+/** Początkowa liczba miejsc w tablicy. Musi być potęgą dwójki. */
+#define INTERN_INITIAL_CAPACITY 1024
+
+/**
+ * To jest struktura przechowująca miejsce w tablicy postaci kanonicznych.
+ */
+typedef struct InternEntry {
+    Mono *arr; ///< tablica jednomianów lub NULL dla wolnego miejsca
+    size_t size; ///< liczba jednomianów
+    size_t hash; ///< skrót tablicy jednomianów
+} InternEntry;
+
+/** Miejsca tablicy, adresowane otwarcie z liniowym próbkowaniem. */
+static InternEntry *table = NULL;
+
+/** Liczba miejsc tablicy. */
+static size_t capacity = 0;
+
+/** Liczba zajętych miejsc tablicy. */
+static size_t count = 0;
+
+/**
+ * Dołącza wartość do skrótu.
+ * @param[in] hash : dotychczasowy skrót
+ * @param[in] value : wartość
+ * @return nowy skrót
+ */
+static size_t Mix(size_t hash, uint64_t value) {
+    uint64_t x = (hash ^ value) * 0x9e3779b97f4a7c15ULL;
+    return (size_t) (x ^ (x >> 29));
+}
+
+size_t PolyHash(const Poly *p) {
+    if (PolyIsCoeff(p))
+        return Mix(0, (uint64_t) p->coeff);
+    size_t hash = Mix(1, p->size);
+    for (size_t i = 0; i < p->size; i++) {
+        hash = Mix(hash, (uint64_t) p->arr[i].exp);
+        hash = Mix(hash, PolyHash(&p->arr[i].p));
+    }
+    return hash;
+}
+
+/**
+ * Wylicza skrót tablicy jednomianów, których współczynniki są już w tablicy
+ * postaci kanonicznych, więc wystarczy porównywać ich adresy.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] size : liczba jednomianów
+ * @return skrót tablicy jednomianów
+ */
+static size_t ShallowHash(const Mono *arr, size_t size) {
+    size_t hash = Mix(1, size);
+    for (size_t i = 0; i < size; i++) {
+        hash = Mix(hash, (uint64_t) arr[i].exp);
+        if (arr[i].p.arr == NULL)
+            hash = Mix(hash, (uint64_t) arr[i].p.coeff);
+        else
+            hash = Mix(hash, (uint64_t) (uintptr_t) arr[i].p.arr);
+    }
+    return hash;
+}
+
+/**
+ * Porównuje tablice jednomianów, których współczynniki są już w tablicy
+ * postaci kanonicznych.
+ * @param[in] entry : miejsce tablicy
+ * @param[in] arr : tablica jednomianów
+ * @param[in] size : liczba jednomianów
+ * @return czy tablice są równe
+ */
+static bool ShallowEq(const InternEntry *entry, const Mono *arr, size_t size) {
+    if (entry->size != size)
+        return false;
+    for (size_t i = 0; i < size; i++) {
+        const Mono *a = &entry->arr[i], *b = &arr[i];
+        if (a->exp != b->exp || a->p.arr != b->p.arr)
+            return false;
+        if (a->p.arr == NULL && a->p.coeff != b->p.coeff)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Powiększa tablicę dwukrotnie, przenosząc zajęte miejsca.
+ */
+static void Grow(void) {
+    size_t new_capacity = capacity == 0 ? INTERN_INITIAL_CAPACITY : 2 * capacity;
+    InternEntry *new_table = (InternEntry *) SafeCalloc(new_capacity, sizeof(InternEntry));
+    for (size_t i = 0; i < capacity; i++) {
+        if (table[i].arr == NULL)
+            continue;
+        size_t j = table[i].hash & (new_capacity - 1);
+        while (new_table[j].arr != NULL)
+            j = (j + 1) & (new_capacity - 1);
+        new_table[j] = table[i];
+    }
+    free(table);
+    table = new_table;
+    capacity = new_capacity;
+}
+
+Poly PolyIntern(Poly *p) {
+    if (PolyIsCoeff(p) || BlockIsInterned(p->arr) || !BlockCanShare(p->arr))
+        return *p;
+
+    //Zamiana współczynników na równe im nie zmienia wartości wielomianu,
+    //więc można to robić w miejscu nawet we współdzielonej tablicy.
+    for (size_t i = 0; i < p->size; i++)
+        p->arr[i].p = PolyIntern(&p->arr[i].p);
+
+    if (2 * (count + 1) > capacity)
+        Grow();
+    size_t hash = ShallowHash(p->arr, p->size);
+    size_t i = hash & (capacity - 1);
+    while (table[i].arr != NULL) {
+        if (table[i].hash == hash && ShallowEq(&table[i], p->arr, p->size)) {
+            BlockShare(table[i].arr);
+            Poly found = {.size = table[i].size, .arr = table[i].arr};
+            PolyDestroy(p);
+            return found;
+        }
+        i = (i + 1) & (capacity - 1);
+    }
+
+    table[i] = (InternEntry) {.arr = p->arr, .size = p->size, .hash = hash};
+    count++;
+    BlockSetInterned(p->arr, true);
+    return *p;
+}
+
+void PolyInternForget(const Poly *p) {
+    size_t mask = capacity - 1;
+    size_t i = ShallowHash(p->arr, p->size) & mask;
+    while (table[i].arr != p->arr)
+        i = (i + 1) & mask;
+
+    //Przesuwamy wstecz kolejne miejsca, które bez usuwanego byłyby nieosiągalne.
+    for (size_t j = (i + 1) & mask; table[j].arr != NULL; j = (j + 1) & mask) {
+        size_t home = table[j].hash & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            table[i] = table[j];
+            i = j;
+        }
+    }
+    table[i].arr = NULL;
+    count--;
+}
+
+size_t PolyInternCount(void) {
+    return count;
+}
+
+void PolyInternRelease(void) {
+    if (count > 0)
+        return;
+    free(table);
+    table = NULL;
+    capacity = 0;
+}
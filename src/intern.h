@@ -0,0 +1,59 @@
+/** @file
+  Interfejs tablicy wielomianów w postaci kanonicznej.
+
+  Wielomiany wstawione do tablicy funkcją PolyIntern dzielą tablice jednomianów
+  z wszystkimi równymi im wielomianami w tablicy, więc dwa takie wielomiany
+  są równe wtedy i tylko wtedy, gdy mają tę samą tablicę jednomianów.
+  Tablica nie przedłuża życia wielomianów: tablica jednomianów znika z niej,
+  gdy zostanie zwolnione ostatnie odwołanie do niej.
+  Tablica jest wspólna dla całego programu i nie jest bezpieczna wielowątkowo.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef INTERN_H
+#define INTERN_H
+
+#include "poly.h"
+
+/**
+ * Wylicza skrót wielomianu zależny tylko od jego postaci,
+ * a nie od położenia w pamięci: równe wielomiany mają równe skróty.
+ * @param[in] p : wielomian @f$p@f$
+ * @return skrót wielomianu
+ */
+size_t PolyHash(const Poly *p);
+
+/**
+ * Zamienia wielomian na równy mu wielomian z tablicy postaci kanonicznych,
+ * wstawiając do tablicy brakujące poddrzewa.
+ * Przejmuje na własność zawartość struktury wskazywanej przez @p p.
+ * Wielomiany z aren oraz wielomiany przetwarzane przy ustawionej arenie
+ * nie są wstawiane do tablicy i są zwracane bez zmian.
+ * @param[in] p : wielomian @f$p@f$
+ * @return wielomian równy @f$p@f$
+ */
+Poly PolyIntern(Poly *p);
+
+/**
+ * Usuwa tablicę jednomianów z tablicy postaci kanonicznych.
+ * Wywoływana przez PolyDestroy przy zwalnianiu ostatniego odwołania
+ * do oznaczonej tablicy, zanim zostaną zwolnione jej współczynniki.
+ * @param[in] p : wielomian, którego tablica jednomianów jest w tablicy
+ */
+void PolyInternForget(const Poly *p);
+
+/**
+ * Zwraca liczbę tablic jednomianów w tablicy postaci kanonicznych.
+ * @return liczba tablic jednomianów
+ */
+size_t PolyInternCount(void);
+
+/**
+ * Zwalnia pamięć tablicy postaci kanonicznych, jeśli jest pusta.
+ */
+void PolyInternRelease(void);
+
+#endif //INTERN_H
@@ -0,0 +1,256 @@
+/** @file
+  Implementacja leniwie wyliczanych wyrażeń na wielomianach.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <stdlib.h>
+#include "lazy.h"
+#include "memory.h"
+
+struct LazyNode {
+    LazyKind kind; ///< rodzaj węzła
+    unsigned refs; ///< liczba odwołań
+    bool forced; ///< czy wartość jest wyliczona
+    Poly value; ///< wartość, jeśli jest wyliczona
+    LazyNode *left; ///< pierwszy argument lub NULL
+    LazyNode *right; ///< drugi argument lub NULL
+};
+
+/**
+ * To jest struktura przechowująca składnik spłaszczonej sumy.
+ */
+typedef struct LazyTerm {
+    LazyNode *node; ///< węzeł składnika
+    bool negative; ///< czy składnik jest odejmowany
+} LazyTerm;
+
+/**
+ * To jest struktura przechowująca rosnącą tablicę składników,
+ * używaną również jako stos węzłów do przejrzenia.
+ */
+typedef struct TermStack {
+    LazyTerm *arr; ///< elementy
+    size_t size; ///< liczba elementów
+    size_t capacity; ///< pojemność tablicy
+} TermStack;
+
+/**
+ * Wstawia element na koniec tablicy.
+ * @param[in,out] stack : tablica
+ * @param[in] node : węzeł
+ * @param[in] negative : czy składnik jest odejmowany
+ */
+static void TermPush(TermStack *stack, LazyNode *node, bool negative) {
+    if (stack->size == stack->capacity) {
+        stack->capacity = stack->capacity == 0 ? 16 : 2 * stack->capacity;
+        stack->arr = (LazyTerm *) SafeRealloc(stack->arr, stack->capacity * sizeof(LazyTerm));
+    }
+    stack->arr[stack->size++] = (LazyTerm) {.node = node, .negative = negative};
+}
+
+/**
+ * Tworzy węzeł operacji.
+ * @param[in] kind : rodzaj węzła
+ * @param[in] left : pierwszy argument
+ * @param[in] right : drugi argument lub NULL
+ * @return węzeł z jednym odwołaniem
+ */
+static LazyNode *LazyNew(LazyKind kind, LazyNode *left, LazyNode *right) {
+    LazyNode *node = (LazyNode *) SafeMalloc(sizeof(LazyNode));
+    *node = (LazyNode) {.kind = kind, .refs = 1, .forced = false, .value = PolyZero(), .left = left, .right = right};
+    return node;
+}
+
+LazyNode *LazyFromPoly(Poly p) {
+    LazyNode *node = LazyNew(LAZY_VALUE, NULL, NULL);
+    node->forced = true;
+    node->value = p;
+    return node;
+}
+
+/**
+ * Sprawdza, czy węzeł jest niewyliczoną negacją, do której odwołuje się
+ * tylko budowany węzeł, więc można go rozebrać.
+ * @param[in] node : węzeł
+ * @return czy węzeł można zastąpić jego argumentem
+ */
+static bool IsOwnedNeg(const LazyNode *node) {
+    return node->kind == LAZY_NEG && !node->forced && node->refs == 1;
+}
+
+/**
+ * Rozbiera niewyliczoną negację, do której nie ma innych odwołań.
+ * @param[in] node : negacja
+ * @return odwołanie do argumentu negacji
+ */
+static LazyNode *Unwrap(LazyNode *node) {
+    LazyNode *arg = node->left;
+    free(node);
+    return arg;
+}
+
+LazyNode *LazyNeg(LazyNode *a) {
+    if (IsOwnedNeg(a))
+        return Unwrap(a);
+    return LazyNew(LAZY_NEG, a, NULL);
+}
+
+LazyNode *LazyBinary(LazyKind kind, LazyNode *p, LazyNode *q) {
+    assert(kind == LAZY_ADD || kind == LAZY_SUB || kind == LAZY_MUL);
+    if (kind == LAZY_ADD && IsOwnedNeg(q))
+        return LazyNew(LAZY_SUB, p, Unwrap(q));
+    if (kind == LAZY_ADD && IsOwnedNeg(p))
+        return LazyNew(LAZY_SUB, q, Unwrap(p));
+    if (kind == LAZY_SUB && IsOwnedNeg(q))
+        return LazyNew(LAZY_ADD, p, Unwrap(q));
+    return LazyNew(kind, p, q);
+}
+
+LazyNode *LazyShare(LazyNode *node) {
+    node->refs++;
+    return node;
+}
+
+void LazyRelease(LazyNode *node) {
+    //Wyrażenia mogą być bardzo głębokie, więc przechodzimy je bez rekurencji.
+    TermStack pending = {.arr = NULL, .size = 0, .capacity = 0};
+    TermPush(&pending, node, false);
+    while (pending.size > 0) {
+        LazyNode *n = pending.arr[--pending.size].node;
+        if (--n->refs > 0)
+            continue;
+        if (n->forced)
+            PolyDestroy(&n->value);
+        if (n->left != NULL)
+            TermPush(&pending, n->left, false);
+        if (n->right != NULL)
+            TermPush(&pending, n->right, false);
+        free(n);
+    }
+    free(pending.arr);
+}
+
+/**
+ * Sprawdza, czy węzeł sumy, różnicy lub negacji można rozebrać na składniki
+ * przy wyliczaniu sumy, w której występuje.
+ * @param[in] node : węzeł
+ * @return czy węzeł jest niewyliczony, addytywny i bez innych odwołań
+ */
+static bool IsOwnedAdditive(const LazyNode *node) {
+    return !node->forced && node->refs == 1 &&
+           (node->kind == LAZY_ADD || node->kind == LAZY_SUB || node->kind == LAZY_NEG);
+}
+
+/**
+ * Spłaszcza sumę, różnicę lub negację na listę składników ze znakami.
+ * @param[in] root : węzeł sumy, różnicy lub negacji
+ * @param[out] terms : składniki
+ */
+static void Flatten(LazyNode *root, TermStack *terms) {
+    TermStack pending = {.arr = NULL, .size = 0, .capacity = 0};
+    terms->size = 0;
+    TermPush(&pending, root, false);
+    while (pending.size > 0) {
+        LazyTerm term = pending.arr[--pending.size];
+        LazyNode *n = term.node;
+        if (n != root && !IsOwnedAdditive(n)) {
+            TermPush(terms, n, term.negative);
+            continue;
+        }
+        //Prawy argument wstawiamy pierwszy, żeby składniki były w kolejności z wyrażenia.
+        if (n->right != NULL)
+            TermPush(&pending, n->right, n->kind == LAZY_SUB ? !term.negative : term.negative);
+        TermPush(&pending, n->left, n->kind == LAZY_NEG ? !term.negative : term.negative);
+    }
+    free(pending.arr);
+}
+
+/**
+ * Oddaje wartość wyliczonego argumentu na potrzeby wyliczenia węzła.
+ * Jeśli argument nie ma innych odwołań, jego wartość jest przenoszona,
+ * a w przeciwnym przypadku kopiowana.
+ * @param[in] node : wyliczony argument
+ * @return wartość argumentu
+ */
+static Poly TakeValue(LazyNode *node) {
+    if (node->refs > 1)
+        return PolyClone(&node->value);
+    Poly p = node->value;
+    node->value = PolyZero();
+    return p;
+}
+
+/**
+ * Wylicza wartość węzła, którego argumenty są już wyliczone, i usuwa
+ * odwołania do argumentów.
+ * @param[in,out] node : węzeł
+ * @param[in] terms : składniki węzła, jeśli jest on sumą, różnicą lub negacją
+ */
+static void Evaluate(LazyNode *node, const TermStack *terms) {
+    if (node->kind == LAZY_MUL) {
+        Poly p = TakeValue(node->left);
+        Poly q = TakeValue(node->right);
+        node->value = PolyMulOwn(&p, &q);
+    } else {
+        Poly *values = (Poly *) SafeMalloc(terms->size * sizeof(Poly));
+        for (size_t i = 0; i < terms->size; i++) {
+            values[i] = TakeValue(terms->arr[i].node);
+            if (terms->arr[i].negative)
+                PolyNegInPlace(&values[i]);
+        }
+        node->value = PolySumManyOwn(terms->size, values);
+        free(values);
+    }
+    node->forced = true;
+    LazyRelease(node->left);
+    if (node->right != NULL)
+        LazyRelease(node->right);
+    node->left = node->right = NULL;
+}
+
+const Poly *LazyForce(LazyNode *node) {
+    TermStack pending = {.arr = NULL, .size = 0, .capacity = 0};
+    TermStack terms = {.arr = NULL, .size = 0, .capacity = 0};
+    TermPush(&pending, node, false);
+    while (pending.size > 0) {
+        LazyNode *n = pending.arr[pending.size - 1].node;
+        if (n->forced) {
+            pending.size--;
+            continue;
+        }
+
+        if (n->kind == LAZY_MUL) {
+            terms.size = 0;
+            TermPush(&terms, n->left, false);
+            TermPush(&terms, n->right, false);
+        } else {
+            Flatten(n, &terms);
+        }
+
+        //Najpierw wyliczamy argumenty, a do węzła wracamy, gdy wszystkie są gotowe.
+        bool ready = true;
+        for (size_t i = 0; i < terms.size; i++) {
+            if (!terms.arr[i].node->forced) {
+                TermPush(&pending, terms.arr[i].node, false);
+                ready = false;
+            }
+        }
+        if (ready) {
+            Evaluate(n, &terms);
+            pending.size--;
+        }
+    }
+    free(pending.arr);
+    free(terms.arr);
+    return &node->value;
+}
+
+Poly LazyTake(LazyNode *node) {
+    LazyForce(node);
+    Poly p = TakeValue(node);
+    LazyRelease(node);
+    return p;
+}
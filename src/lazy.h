@@ -0,0 +1,96 @@
+/** @file
+  Interfejs leniwie wyliczanych wyrażeń na wielomianach.
+
+  Wyrażenie jest grafem węzłów: liści przechowujących wielomiany oraz
+  operacji, których argumentami są inne węzły. Węzły mają liczniki
+  odwołań, więc jeden węzeł może być argumentem wielu operacji.
+  Wartość węzła jest wyliczana dopiero przy pierwszym odwołaniu do niej
+  i zapamiętywana w węźle. Usunięcie niewyliczonego węzła nic nie liczy.
+
+  Przy wyliczaniu sumy spłaszczane są wszystkie sumy, różnice i negacje,
+  do których nie odwołuje się nic poza nią, a powstałe składniki są
+  dodawane razem, zamiast parami w kolejności budowania wyrażenia.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef LAZY_H
+#define LAZY_H
+
+#include "poly.h"
+
+/**
+ * To jest typ wyznaczający rodzaj węzła wyrażenia.
+ */
+typedef enum LazyKind {
+    LAZY_VALUE, ///< wielomian
+    LAZY_ADD, ///< suma dwóch argumentów
+    LAZY_SUB, ///< różnica pierwszego i drugiego argumentu
+    LAZY_MUL, ///< iloczyn dwóch argumentów
+    LAZY_NEG ///< negacja argumentu
+} LazyKind;
+
+/**
+ * To jest struktura przechowująca węzeł wyrażenia.
+ */
+typedef struct LazyNode LazyNode;
+
+/**
+ * Tworzy węzeł przechowujący wielomian. Przejmuje wielomian na własność.
+ * @param[in] p : wielomian
+ * @return węzeł z jednym odwołaniem
+ */
+LazyNode *LazyFromPoly(Poly p);
+
+/**
+ * Tworzy węzeł negacji. Przejmuje odwołanie do argumentu.
+ * Negacja niewyliczonej negacji, do której nie ma innych odwołań,
+ * jest od razu skracana.
+ * @param[in] a : argument
+ * @return węzeł z jednym odwołaniem
+ */
+LazyNode *LazyNeg(LazyNode *a);
+
+/**
+ * Tworzy węzeł operacji dwuargumentowej. Przejmuje odwołania do argumentów.
+ * Suma z negacją jest od razu zamieniana na różnicę, a różnica z negacją na sumę.
+ * @param[in] kind : LAZY_ADD, LAZY_SUB albo LAZY_MUL
+ * @param[in] p : pierwszy argument
+ * @param[in] q : drugi argument
+ * @return węzeł z jednym odwołaniem
+ */
+LazyNode *LazyBinary(LazyKind kind, LazyNode *p, LazyNode *q);
+
+/**
+ * Dodaje odwołanie do węzła.
+ * @param[in] node : węzeł
+ * @return ten sam węzeł
+ */
+LazyNode *LazyShare(LazyNode *node);
+
+/**
+ * Wylicza wartość węzła, o ile nie była już wyliczona.
+ * @param[in] node : węzeł
+ * @return wartość węzła, ważna do usunięcia ostatniego odwołania do niego
+ */
+const Poly *LazyForce(LazyNode *node);
+
+/**
+ * Wylicza wartość węzła i oddaje ją na własność wołającemu, usuwając
+ * jedno odwołanie do węzła. Jeśli było to ostatnie odwołanie, wartość
+ * jest przenoszona bez kopiowania.
+ * @param[in] node : węzeł
+ * @return wartość węzła
+ */
+Poly LazyTake(LazyNode *node);
+
+/**
+ * Usuwa odwołanie do węzła. Po usunięciu ostatniego odwołania zwalnia węzeł
+ * razem z odwołaniami do jego argumentów, niczego nie wyliczając.
+ * @param[in] node : węzeł
+ */
+void LazyRelease(LazyNode *node);
+
+#endif //LAZY_H
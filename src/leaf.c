@@ -0,0 +1,224 @@
+/** @file
+  Implementacja szybkich ścieżek dla wielomianów liściowych.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "leaf.h"
+#include "memory.h"
+#include "canon.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+/** Czy kompilator pozwala użyć instrukcji AVX2 po sprawdzeniu procesora w czasie działania. */
+#define LEAF_SIMD 1
+#else
+/** Czy kompilator pozwala użyć instrukcji AVX2 po sprawdzeniu procesora w czasie działania. */
+#define LEAF_SIMD 0
+#endif
+
+Leaf LeafNew(size_t capacity) {
+    //Obie tablice leżą w jednym bloku: najpierw współczynniki, potem wykładniki.
+    unsigned char *memory = (unsigned char *) SafeMalloc(capacity * (sizeof(unsigned long) + sizeof(poly_exp_t)) + 1);
+    return (Leaf) {
+        .size = 0,
+        .coeff = (unsigned long *) memory,
+        .exp = (poly_exp_t *) (memory + capacity * sizeof(unsigned long))
+    };
+}
+
+bool LeafLoad(const Poly *p, Leaf *leaf) {
+    //Najczęściej już pierwszy współczynnik pokazuje, że wielomian nie jest liściowy.
+    if (!PolyIsCoeff(&p->arr[0].p))
+        return false;
+    *leaf = LeafNew(p->size);
+    for (size_t i = 0; i < p->size; i++) {
+        if (!PolyIsCoeff(&p->arr[i].p)) {
+            LeafFree(leaf);
+            return false;
+        }
+        leaf->exp[i] = p->arr[i].exp;
+        leaf->coeff[i] = (unsigned long) p->arr[i].p.coeff;
+    }
+    leaf->size = p->size;
+    return true;
+}
+
+void LeafFree(Leaf *leaf) {
+    free(leaf->coeff);
+}
+
+/**
+ * To jest typ funkcji zwracającej długość początkowego ciągu jednomianów
+ * o wykładnikach mniejszych od zadanego ograniczenia.
+ */
+typedef size_t (*RunBelowFn)(const Mono *arr, size_t n, poly_exp_t bound);
+
+/**
+ * Zwraca długość początkowego ciągu jednomianów o wykładnikach mniejszych
+ * od ograniczenia, sprawdzając wykładniki po kolei.
+ * @param[in] arr : tablica jednomianów o rosnących wykładnikach
+ * @param[in] n : liczba jednomianów
+ * @param[in] bound : ograniczenie
+ * @return długość ciągu
+ */
+static size_t RunBelowScalar(const Mono *arr, size_t n, poly_exp_t bound) {
+    size_t k = 0;
+    while (k < n && arr[k].exp < bound)
+        k++;
+    return k;
+}
+
+#if LEAF_SIMD
+/**
+ * Zwraca długość początkowego ciągu jednomianów o wykładnikach mniejszych
+ * od ograniczenia, porównując po osiem wykładników naraz instrukcjami AVX2.
+ * Wykładniki są zbierane z tablicy jednomianów instrukcją gather.
+ * @param[in] arr : tablica jednomianów o rosnących wykładnikach
+ * @param[in] n : liczba jednomianów
+ * @param[in] bound : ograniczenie
+ * @return długość ciągu
+ */
+__attribute__((target("avx2")))
+static size_t RunBelowAvx2(const Mono *arr, size_t n, poly_exp_t bound) {
+    const int stride = (int) (sizeof(Mono) / sizeof(int));
+    const __m256i index = _mm256_setr_epi32(0, stride, 2 * stride, 3 * stride,
+                                            4 * stride, 5 * stride, 6 * stride, 7 * stride);
+    const __m256i limit = _mm256_set1_epi32(bound);
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        __m256i exp = _mm256_i32gather_epi32((const int *) &arr[k].exp, index, sizeof(int));
+        unsigned below = (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(limit, exp)));
+        //Wykładniki rosną, więc ustawione bity maski tworzą jej początek.
+        if (below != 0xFF)
+            return k + (size_t) __builtin_ctz(~below);
+    }
+    return k + RunBelowScalar(arr + k, n - k, bound);
+}
+#endif
+
+/**
+ * Wybiera przy pierwszym użyciu najszybszą wersję funkcji szukającej ciągów
+ * dostępną na bieżącym procesorze i wywołuje ją. Kilka wątków może wybierać
+ * naraz, ale każdy zapisuje tę samą wersję.
+ * @param[in] arr : tablica jednomianów o rosnących wykładnikach
+ * @param[in] n : liczba jednomianów
+ * @param[in] bound : ograniczenie
+ * @return długość ciągu
+ */
+static size_t RunBelowDispatch(const Mono *arr, size_t n, poly_exp_t bound);
+
+/** Wersja funkcji szukającej ciągów, używana przez LeafAdd wywoływaną także w wątkach puli. */
+static _Atomic RunBelowFn run_below = RunBelowDispatch;
+
+static size_t RunBelowDispatch(const Mono *arr, size_t n, poly_exp_t bound) {
+    RunBelowFn chosen = RunBelowScalar;
+#if LEAF_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        chosen = RunBelowAvx2;
+#endif
+    atomic_store_explicit(&run_below, chosen, memory_order_relaxed);
+    return chosen(arr, n, bound);
+}
+
+/** Długość ciągu jednomianów jednego składnika, od której LeafAdd kopiuje go w całości. */
+#define LEAF_RUN_PROBE 4
+
+/** Stosunek liczb jednomianów składników, od którego LeafAdd szuka długich ciągów. */
+#define LEAF_RUN_RATIO 4
+
+/**
+ * Zamienia jednomiany przepisane bajt po bajcie w pełne kopie:
+ * współczynniki, które nie są liczbami, kopiuje funkcją PolyClone.
+ * Na poziomach liściowych tylko sprawdza współczynniki, które dopiero co
+ * zostały przepisane i są w pamięci podręcznej.
+ * @param[in,out] arr : przepisane jednomiany
+ * @param[in] n : liczba jednomianów
+ */
+static inline void CloneNested(Mono *arr, size_t n) {
+    for (size_t k = 0; k < n; k++) {
+        if (!PolyIsCoeff(&arr[k].p))
+            arr[k].p = PolyClone(&arr[k].p);
+    }
+}
+
+/**
+ * Sprawdza, czy składnik ma przed ograniczeniem ciąg co najmniej
+ * LEAF_RUN_PROBE jednomianów, i jeśli tak, kopiuje cały ten ciąg
+ * na koniec wyniku.
+ * @param[out] dst : miejsce w tablicy wynikowej
+ * @param[in] src : jednomiany składnika o rosnących wykładnikach
+ * @param[in] n : liczba jednomianów składnika
+ * @param[in] bound : ograniczenie
+ * @return liczba przepisanych jednomianów
+ */
+static inline size_t CopyRun(Mono *dst, const Mono *src, size_t n, poly_exp_t bound) {
+    if (n < LEAF_RUN_PROBE || src[LEAF_RUN_PROBE - 1].exp >= bound)
+        return 0;
+    RunBelowFn find_run = atomic_load_explicit(&run_below, memory_order_relaxed);
+    size_t run = LEAF_RUN_PROBE + find_run(src + LEAF_RUN_PROBE, n - LEAF_RUN_PROBE, bound);
+    memcpy(dst, src, run * sizeof(Mono));
+    CloneNested(dst, run);
+    return run;
+}
+
+Poly LeafAdd(const Poly *p, const Poly *q) {
+    //Zapisy do tablicy wynikowej mogłyby zmieniać składniki, więc bez kopii
+    //w zmiennych lokalnych kompilator wczytywałby je w każdym obrocie pętli.
+    const Mono *p_arr = p->arr, *q_arr = q->arr;
+    const size_t p_size = p->size, q_size = q->size;
+    Mono *arr = (Mono *) BlockAlloc((p_size + q_size) * sizeof(Mono));
+    size_t size = 0, i = 0, j = 0;
+    //Ciągi jednomianów jednego składnika mają średnio długość co najmniej
+    //stosunku liczb jednomianów. Przy składnikach podobnej wielkości
+    //wykładniki zwykle się przeplatają i samo sprawdzanie, czy zaczyna się
+    //długi ciąg, kosztuje więcej, niż pozwala zyskać.
+    size_t smaller = p_size < q_size ? p_size : q_size, larger = p_size + q_size - smaller;
+    bool runs = larger >= LEAF_RUN_RATIO * smaller;
+    while (i < p_size && j < q_size) {
+        if (p_arr[i].exp < q_arr[j].exp) {
+            arr[size] = p_arr[i++];
+            CloneNested(arr + size++, 1);
+            if (runs) {
+                size_t run = CopyRun(arr + size, p_arr + i, p_size - i, q_arr[j].exp);
+                size += run;
+                i += run;
+            }
+        } else if (p_arr[i].exp > q_arr[j].exp) {
+            arr[size] = q_arr[j++];
+            CloneNested(arr + size++, 1);
+            if (runs) {
+                size_t run = CopyRun(arr + size, q_arr + j, q_size - j, p_arr[i].exp);
+                size += run;
+                j += run;
+            }
+        } else {
+            //Pary współczynników liczbowych sumujemy bez wywołania rekurencyjnego.
+            Poly sum;
+            if (PolyIsCoeff(&p_arr[i].p) && PolyIsCoeff(&q_arr[j].p)) {
+                unsigned long value = (unsigned long) p_arr[i].p.coeff + (unsigned long) q_arr[j].p.coeff;
+                sum = PolyFromCoeff((poly_coeff_t) value);
+            } else {
+                sum = PolyAdd(&p_arr[i].p, &q_arr[j].p);
+            }
+            if (!PolyIsZero(&sum)) {
+                arr[size].p = sum;
+                arr[size++].exp = p_arr[i].exp;
+            }
+            i++;
+            j++;
+        }
+    }
+    //Reszty są już posortowane, więc przepisujemy je w całości.
+    memcpy(arr + size, p_arr + i, (p_size - i) * sizeof(Mono));
+    memcpy(arr + size + (p_size - i), q_arr + j, (q_size - j) * sizeof(Mono));
+    CloneNested(arr + size, (p_size - i) + (q_size - j));
+    size += (p_size - i) + (q_size - j);
+    return PolyFinish(arr, size);
+}
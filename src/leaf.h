@@ -0,0 +1,67 @@
+/** @file
+  Interfejs szybkich ścieżek dla wielomianów liściowych.
+
+  Wielomian liściowy to wielomian, którego wszystkie współczynniki są liczbami.
+  Takie wielomiany są na najniższych poziomach drzewa i to na nich wykonuje się
+  większość pracy. Układ tablicy jednomianów jest ustalony przez poly.h,
+  więc funkcje tego modułu działają bezpośrednio na tablicy jednomianów
+  w pętlach bez rekurencji, a tam, gdzie tablica jest czytana wiele razy,
+  kopiują wykładniki i współczynniki do osobnych, ciągłych tablic.
+  To, czy poziom jest liściowy, rozpoznają w trakcie tej pracy,
+  bez osobnego przeglądania tablicy jednomianów.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef LEAF_H
+#define LEAF_H
+
+#include "poly.h"
+
+/**
+ * To jest struktura przechowująca wielomian liściowy jako dwie ciągłe tablice:
+ * wykładników i współczynników. Współczynniki są liczbami bez znaku,
+ * żeby przepełnienia działały modulo @f$2^{64}@f$.
+ */
+typedef struct Leaf {
+    size_t size; ///< liczba jednomianów
+    poly_exp_t *exp; ///< wykładniki, rosnąco
+    unsigned long *coeff; ///< współczynniki
+} Leaf;
+
+/**
+ * Tworzy pusty wielomian liściowy o zadanej pojemności.
+ * @param[in] capacity : liczba miejsc na jednomiany
+ * @return wielomian liściowy bez jednomianów
+ */
+Leaf LeafNew(size_t capacity);
+
+/**
+ * Kopiuje wielomian do postaci dwóch tablic, jeśli jest liściowy.
+ * @param[in] p : wielomian, który nie jest współczynnikiem
+ * @param[out] leaf : wielomian w postaci dwóch tablic, ustawiany tylko w razie powodzenia
+ * @return czy wielomian jest liściowy
+ */
+bool LeafLoad(const Poly *p, Leaf *leaf);
+
+/**
+ * Zwalnia pamięć wielomianu w postaci dwóch tablic.
+ * @param[in] leaf : wielomian w postaci dwóch tablic
+ */
+void LeafFree(Leaf *leaf);
+
+/**
+ * Dodaje dwa wielomiany, które nie są współczynnikami, scalając ich jednomiany.
+ * Pary współczynników liczbowych są sumowane bez wywołań rekurencyjnych,
+ * a długie ciągi jednomianów jednego składnika są przepisywane w całości.
+ * Współczynniki, które nie są liczbami, są dodawane funkcją PolyAdd
+ * i kopiowane funkcją PolyClone.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+Poly LeafAdd(const Poly *p, const Poly *q);
+
+#endif //LEAF_H
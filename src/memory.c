@@ -1,35 +1,362 @@
-/** @file
-  Implementacja modułu alokującego pamięć.
-
-  @author Daniel Mastalerz
-  @copyright Uniwersytet Warszawski
-  @date 2021
-*/
-
-//To jest makro potrzebne do działania funkcji getline.
-#define _GNU_SOURCE
-
-#include <stdlib.h>
-#include <errno.h>
-#include "memory.h"
-
-void *SafeMalloc(size_t size) {
-    void *allocated = malloc(size);
-    if (allocated != NULL) return allocated;
-    exit(1);
-}
-
-void *SafeRealloc(void* ptr, size_t size) {
-    void* allocated = realloc(ptr, size);
-    if (allocated != NULL) {
-        return allocated;
-    }
-    exit(1);
-}
-
-ssize_t SafeGetLine(char** line, size_t *n, FILE* stream) {
-    errno = 0;
-    ssize_t x = getline(line, n, stream);
-    if (errno == ENOMEM) exit(1);
-    return x;
-}
\ No newline at end of file
+/** @file
+  Implementacja modułu alokującego pamięć.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "memory.h"
+
+/** Ziarnistość klas wielkości bloków puli. */
+#define POOL_GRANULARITY 16
+
+/** Liczba klas wielkości bloków puli. Większe bloki są alokowane bezpośrednio na stercie. */
+#define POOL_CLASSES 16
+
+/** Maksymalna liczba wolnych bloków przechowywanych w jednej klasie puli. */
+#define POOL_MAX_FREE 4096
+
+/** Wielkość pierwszego kawałka areny. */
+#define ARENA_FIRST_CHUNK 4096
+
+/** Wyrównanie bloków przydzielanych z areny. */
+#define ARENA_ALIGN 16
+
+/**
+ * To jest typ wyznaczający pochodzenie bloku zaalokowanego przez BlockAlloc.
+ */
+enum BlockKind {
+    BLOCK_HEAP, ///< blok ze sterty
+    BLOCK_ARENA, ///< blok z areny
+    BLOCK_POOL ///< blok z puli małych bloków
+};
+
+/**
+ * To jest nagłówek bloku zaalokowanego przez BlockAlloc, poprzedzający jego zawartość.
+ */
+typedef struct BlockHeader {
+    size_t size; ///< wielkość zawartości bloku, a dla bloków z puli pojemność klasy
+    unsigned short kind; ///< pochodzenie bloku
+    unsigned short interned; ///< czy blok jest w tablicy postaci kanonicznych
+    _Atomic unsigned refs; ///< liczba odwołań do bloku, zmieniana atomowo
+} BlockHeader;
+
+/**
+ * To jest struktura przechowująca listę wolnych bloków jednej klasy wielkości.
+ * Wskaźnik na następny wolny blok jest trzymany w zawartości bloku.
+ */
+typedef struct PoolClass {
+    void *head; ///< pierwszy wolny blok
+    size_t count; ///< liczba wolnych bloków
+} PoolClass;
+
+/** Pula małych bloków bieżącego wątku. */
+static _Thread_local PoolClass pool[POOL_CLASSES];
+
+/** Statystyki puli małych bloków bieżącego wątku. */
+static _Thread_local BlockPoolStats pool_stats;
+
+/**
+ * To jest struktura przechowująca kawałek areny. Kawałki tworzą listę
+ * od najnowszego do najstarszego, a bloki są przydzielane z najnowszego.
+ */
+typedef struct ArenaChunk {
+    struct ArenaChunk *next; ///< starszy kawałek
+    size_t size; ///< wielkość obszaru danych
+    size_t used; ///< liczba zajętych bajtów obszaru danych
+    size_t padding; ///< wyrównanie obszaru danych do ARENA_ALIGN
+    unsigned char data[]; ///< obszar danych
+} ArenaChunk;
+
+struct Arena {
+    ArenaChunk *chunk; ///< najnowszy kawałek lub NULL, jeśli nic jeszcze nie przydzielono
+    ArenaChunk *tail; ///< najstarszy kawałek lub NULL
+};
+
+/** Arena, z której bieżący wątek przydziela bloki funkcją BlockAlloc. */
+static _Thread_local Arena *active_arena = NULL;
+
+void *SafeMalloc(size_t size) {
+    void *allocated = malloc(size);
+    if (allocated != NULL) return allocated;
+    exit(1);
+}
+
+void *SafeCalloc(size_t count, size_t size) {
+    void *allocated = calloc(count, size);
+    if (allocated != NULL) return allocated;
+    exit(1);
+}
+
+void *SafeRealloc(void* ptr, size_t size) {
+    void* allocated = realloc(ptr, size);
+    if (allocated != NULL) {
+        return allocated;
+    }
+    exit(1);
+}
+
+/**
+ * Zaokrągla wielkość w górę do wielokrotności ARENA_ALIGN.
+ * @param[in] size : wielkość
+ * @return zaokrąglona wielkość
+ */
+static size_t AlignUp(size_t size) {
+    return (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+}
+
+/**
+ * Tworzy kawałek areny o zadanej wielkości obszaru danych.
+ * @param[in] size : wielkość obszaru danych
+ * @param[in] next : starszy kawałek
+ * @return nowy kawałek
+ */
+static ArenaChunk *ChunkNew(size_t size, ArenaChunk *next) {
+    ArenaChunk *chunk = (ArenaChunk *) SafeMalloc(sizeof(ArenaChunk) + size);
+    chunk->next = next;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+Arena *ArenaNew(void) {
+    Arena *arena = (Arena *) SafeMalloc(sizeof(Arena));
+    //Kawałek powstaje dopiero przy pierwszym przydziale, więc wynik bez bloków, np. współczynnik, nic nie kosztuje.
+    arena->chunk = arena->tail = NULL;
+    return arena;
+}
+
+void *ArenaAlloc(Arena *arena, size_t size) {
+    size = AlignUp(size);
+    ArenaChunk *chunk = arena->chunk;
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        //Kolejne kawałki są coraz większe, więc lista kawałków ma długość logarytmiczną.
+        size_t chunk_size = chunk == NULL ? ARENA_FIRST_CHUNK : 2 * chunk->size;
+        if (chunk_size < size)
+            chunk_size = size;
+        chunk = ChunkNew(chunk_size, chunk);
+        if (arena->chunk == NULL)
+            arena->tail = chunk;
+        arena->chunk = chunk;
+    }
+    void *allocated = chunk->data + chunk->used;
+    chunk->used += size;
+    return allocated;
+}
+
+void ArenaReset(Arena *arena) {
+    if (arena->chunk == NULL)
+        return;
+    //Zostawiamy najnowszy, największy kawałek, żeby kolejne użycie nie alokowało od nowa.
+    ArenaChunk *chunk = arena->chunk->next;
+    while (chunk != NULL) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->chunk->next = NULL;
+    arena->chunk->used = 0;
+    arena->tail = arena->chunk;
+}
+
+void ArenaDestroy(Arena *arena) {
+    if (arena == NULL)
+        return;
+    ArenaChunk *chunk = arena->chunk;
+    while (chunk != NULL) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
+
+void ArenaMerge(Arena *dst, Arena *src) {
+    if (src == NULL || src == dst)
+        return;
+    if (dst->chunk == NULL) {
+        dst->chunk = src->chunk;
+        dst->tail = src->tail;
+    } else if (src->chunk != NULL) {
+        //Kawałki src wstawiamy za najnowszym kawałkiem dst, żeby dalsze przydziały szły z dst.
+        src->tail->next = dst->chunk->next;
+        if (dst->chunk->next == NULL)
+            dst->tail = src->tail;
+        dst->chunk->next = src->chunk;
+    }
+    free(src);
+}
+
+size_t ArenaBytes(const Arena *arena) {
+    if (arena == NULL)
+        return 0;
+    size_t bytes = 0;
+    for (const ArenaChunk *chunk = arena->chunk; chunk != NULL; chunk = chunk->next)
+        bytes += chunk->size;
+    return bytes;
+}
+
+Arena *ArenaUse(Arena *arena) {
+    Arena *previous = active_arena;
+    active_arena = arena;
+    return previous;
+}
+
+Arena *ArenaCurrent(void) {
+    return active_arena;
+}
+
+/**
+ * Sprawdza, czy blok jest ostatnim blokiem przydzielonym z bieżącej areny.
+ * @param[in] header : nagłówek bloku
+ * @return czy blok jest ostatnim blokiem bieżącej areny
+ */
+static bool IsArenaTop(const BlockHeader *header) {
+    if (active_arena == NULL || active_arena->chunk == NULL)
+        return false;
+    ArenaChunk *chunk = active_arena->chunk;
+    return (const unsigned char *) header + sizeof(BlockHeader) + AlignUp(header->size) == chunk->data + chunk->used &&
+           (const unsigned char *) header >= chunk->data;
+}
+
+/**
+ * Wyznacza klasę wielkości puli dla bloku.
+ * @param[in] size : wielkość zawartości bloku
+ * @return indeks klasy lub POOL_CLASSES, jeśli blok jest za duży na pulę
+ */
+static size_t PoolClassOf(size_t size) {
+    if (size > POOL_CLASSES * POOL_GRANULARITY)
+        return POOL_CLASSES;
+    return size == 0 ? 0 : (size - 1) / POOL_GRANULARITY;
+}
+
+void *BlockAlloc(size_t size) {
+    BlockHeader *header;
+    size_t class = PoolClassOf(size);
+    if (active_arena != NULL) {
+        header = (BlockHeader *) ArenaAlloc(active_arena, sizeof(BlockHeader) + size);
+        header->kind = BLOCK_ARENA;
+        header->size = size;
+    } else if (class < POOL_CLASSES) {
+        size_t capacity = (class + 1) * POOL_GRANULARITY;
+        if (pool[class].head != NULL) {
+            header = (BlockHeader *) pool[class].head - 1;
+            pool[class].head = *(void **) pool[class].head;
+            pool[class].count--;
+            pool_stats.hits++;
+        } else {
+            header = (BlockHeader *) SafeMalloc(sizeof(BlockHeader) + capacity);
+            pool_stats.misses++;
+        }
+        header->kind = BLOCK_POOL;
+        header->size = capacity;
+    } else {
+        header = (BlockHeader *) SafeMalloc(sizeof(BlockHeader) + size);
+        header->kind = BLOCK_HEAP;
+        header->size = size;
+    }
+    atomic_store_explicit(&header->refs, 1, memory_order_relaxed);
+    header->interned = false;
+    return header + 1;
+}
+
+bool BlockCanShare(const void *ptr) {
+    //Bloki z aren są zwalniane razem z areną, więc nie mogą mieć odwołań spoza niej,
+    //a bloki budowane w arenie nie mogą odwoływać się do bloków spoza niej.
+    return ((const BlockHeader *) ptr - 1)->kind != BLOCK_ARENA && active_arena == NULL;
+}
+
+bool BlockShare(void *ptr) {
+    if (!BlockCanShare(ptr))
+        return false;
+    atomic_fetch_add_explicit(&((BlockHeader *) ptr - 1)->refs, 1, memory_order_relaxed);
+    return true;
+}
+
+bool BlockIsShared(const void *ptr) {
+    return atomic_load_explicit(&((BlockHeader *) ptr - 1)->refs, memory_order_acquire) > 1;
+}
+
+void BlockSetInterned(void *ptr, bool interned) {
+    ((BlockHeader *) ptr - 1)->interned = interned;
+}
+
+bool BlockIsInterned(const void *ptr) {
+    return ((const BlockHeader *) ptr - 1)->interned;
+}
+
+bool BlockRelease(void *ptr) {
+    BlockHeader *header = (BlockHeader *) ptr - 1;
+    //Jedynego odwołania nikt inny nie może właśnie skopiować, więc wtedy nie zmniejszamy licznika.
+    if (atomic_load_explicit(&header->refs, memory_order_acquire) == 1)
+        return true;
+    return atomic_fetch_sub_explicit(&header->refs, 1, memory_order_acq_rel) == 1;
+}
+
+void *BlockRealloc(void *ptr, size_t size) {
+    if (ptr == NULL)
+        return BlockAlloc(size);
+    BlockHeader *header = (BlockHeader *) ptr - 1;
+    if (header->kind == BLOCK_HEAP && PoolClassOf(size) == POOL_CLASSES) {
+        header = (BlockHeader *) SafeRealloc(header, sizeof(BlockHeader) + size);
+        header->size = size;
+        return header + 1;
+    }
+
+    if (header->kind != BLOCK_HEAP && size <= header->size)
+        return ptr;
+
+    //Ostatni blok areny można powiększyć w miejscu, jeśli w kawałku jest miejsce.
+    ArenaChunk *chunk = active_arena != NULL ? active_arena->chunk : NULL;
+    if (header->kind == BLOCK_ARENA && IsArenaTop(header) && AlignUp(size) - AlignUp(header->size) <= chunk->size - chunk->used) {
+        chunk->used += AlignUp(size) - AlignUp(header->size);
+        header->size = size;
+        return ptr;
+    }
+
+    void *allocated = BlockAlloc(size);
+    memcpy(allocated, ptr, header->size < size ? header->size : size);
+    BlockFree(ptr);
+    return allocated;
+}
+
+void BlockFree(void *ptr) {
+    if (ptr == NULL)
+        return;
+    BlockHeader *header = (BlockHeader *) ptr - 1;
+    if (header->kind == BLOCK_ARENA) {
+        if (IsArenaTop(header))
+            active_arena->chunk->used -= sizeof(BlockHeader) + AlignUp(header->size);
+        return;
+    }
+    if (header->kind == BLOCK_POOL) {
+        PoolClass *class = &pool[PoolClassOf(header->size)];
+        if (class->count < POOL_MAX_FREE) {
+            *(void **) ptr = class->head;
+            class->head = ptr;
+            class->count++;
+            return;
+        }
+    }
+    free(header);
+}
+
+BlockPoolStats BlockPoolGetStats(void) {
+    return pool_stats;
+}
+
+void BlockPoolRelease(void) {
+    for (size_t i = 0; i < POOL_CLASSES; i++) {
+        while (pool[i].head != NULL) {
+            void *next = *(void **) pool[i].head;
+            free((BlockHeader *) pool[i].head - 1);
+            pool[i].head = next;
+        }
+        pool[i].count = 0;
+    }
+}
@@ -1,39 +1,198 @@
-/** @file
-  Interfejs modułu alokującego pamięć.
-
-  @author Daniel Mastalerz
-  @copyright Uniwersytet Warszawski
-  @date 2021
-*/
-
-#ifndef MEMORY_H
-#define MEMORY_H
-
-#include <stdio.h>
-#include <sys/types.h>
-
-/**
- * Alokuje blok pamięci o zadanej wielkości. W przypadku niepowodzenia kończy program z kodem 1.
- * @param[in] size : wielkośc bloku pamięci
- * @return wskaźnik na zaalokowany blok pamięci.
- */
-void *SafeMalloc(size_t size);
-
-/**
- * Realokuje blok pamięci o zadanej wielkości. W przypadku niepowodzenia kończy program z kodem 1.
- * @param[in] ptr : wskaźnik na blok pamięci
- * @param[in] size : nowa wielkość bloku pamięci
- * @return wskaźnik na zaalokowany blok pamięci.
- */
-void *SafeRealloc(void* ptr, size_t size);
-
-/**
- * Wczytuje wiersz ze standardowego wejścia. W przypadku niepowodzenia kończy program z kodem 1.
- * @param[in] line : wskaźnik na wskaźnik na.
- * @param[in] n : wskaźnik na liczbę określającą zaalokowaną pamięć.
- * @param[in] stream : wskaźnik na wejście.
- * @return liczba wczytanych znaków lub -1 w przypadku zakończenia wczytywania.
- */
-ssize_t SafeGetLine(char** line, size_t *n, FILE* stream);
-
+/** @file
+  Interfejs modułu alokującego pamięć.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * To jest struktura przechowująca region pamięci (arenę).
+ * Bloki są przydzielane z regionu przez przesuwanie wskaźnika,
+ * a zwalniane wszystkie naraz przez ArenaReset lub ArenaDestroy.
+ */
+typedef struct Arena Arena;
+
+/**
+ * Alokuje blok pamięci o zadanej wielkości. W przypadku niepowodzenia kończy program z kodem 1.
+ * @param[in] size : wielkośc bloku pamięci
+ * @return wskaźnik na zaalokowany blok pamięci.
+ */
+void *SafeMalloc(size_t size);
+
+/**
+ * Alokuje wyzerowaną tablicę elementów. W przypadku niepowodzenia kończy program z kodem 1.
+ * @param[in] count : liczba elementów
+ * @param[in] size : wielkość jednego elementu
+ * @return wskaźnik na zaalokowany blok pamięci.
+ */
+void *SafeCalloc(size_t count, size_t size);
+
+/**
+ * Realokuje blok pamięci o zadanej wielkości. W przypadku niepowodzenia kończy program z kodem 1.
+ * @param[in] ptr : wskaźnik na blok pamięci
+ * @param[in] size : nowa wielkość bloku pamięci
+ * @return wskaźnik na zaalokowany blok pamięci.
+ */
+void *SafeRealloc(void* ptr, size_t size);
+
+/**
+ * Tworzy nową, pustą arenę. W przypadku niepowodzenia kończy program z kodem 1.
+ * @return wskaźnik na arenę.
+ */
+Arena *ArenaNew(void);
+
+/**
+ * Przydziela blok pamięci z areny. W przypadku niepowodzenia kończy program z kodem 1.
+ * @param[in] arena : arena
+ * @param[in] size : wielkość bloku pamięci
+ * @return wskaźnik na przydzielony blok pamięci.
+ */
+void *ArenaAlloc(Arena *arena, size_t size);
+
+/**
+ * Zwalnia naraz wszystkie bloki przydzielone z areny. Arena może być używana dalej.
+ * @param[in] arena : arena
+ */
+void ArenaReset(Arena *arena);
+
+/**
+ * Zwalnia arenę wraz ze wszystkimi przydzielonymi z niej blokami.
+ * @param[in] arena : arena lub NULL
+ */
+void ArenaDestroy(Arena *arena);
+
+/**
+ * Przenosi wszystkie bloki areny @p src do areny @p dst i zwalnia arenę @p src.
+ * Bloki pozostają na swoich miejscach i będą zwolnione razem z areną @p dst.
+ * Działa w czasie stałym.
+ * @param[in,out] dst : arena docelowa
+ * @param[in] src : dołączana arena lub NULL
+ */
+void ArenaMerge(Arena *dst, Arena *src);
+
+/**
+ * Zwraca łączną wielkość obszarów danych wszystkich kawałków areny.
+ * @param[in] arena : arena lub NULL
+ * @return liczba bajtów zajmowanych przez arenę.
+ */
+size_t ArenaBytes(const Arena *arena);
+
+/**
+ * Ustawia arenę, z której bieżący wątek przydziela bloki funkcją BlockAlloc.
+ * Wartość NULL przywraca przydzielanie bloków na stercie.
+ * @param[in] arena : arena lub NULL
+ * @return poprzednio ustawiona arena.
+ */
+Arena *ArenaUse(Arena *arena);
+
+/**
+ * Zwraca arenę, z której bieżący wątek przydziela bloki funkcją BlockAlloc.
+ * @return ustawiona arena lub NULL.
+ */
+Arena *ArenaCurrent(void);
+
+/**
+ * Alokuje blok pamięci na tablicę jednomianów wielomianu. Blok pochodzi z areny
+ * ustawionej przez ArenaUse, a jeśli jej nie ma, z puli małych bloków
+ * bieżącego wątku lub ze sterty.
+ * W przypadku niepowodzenia kończy program z kodem 1.
+ * @param[in] size : wielkość bloku pamięci
+ * @return wskaźnik na zaalokowany blok pamięci.
+ */
+void *BlockAlloc(size_t size);
+
+/**
+ * Zmienia wielkość bloku zaalokowanego przez BlockAlloc, zachowując jego zawartość.
+ * W przypadku niepowodzenia kończy program z kodem 1.
+ * @param[in] ptr : wskaźnik na blok pamięci
+ * @param[in] size : nowa wielkość bloku pamięci
+ * @return wskaźnik na blok pamięci.
+ */
+void *BlockRealloc(void *ptr, size_t size);
+
+/**
+ * Zwalnia blok zaalokowany przez BlockAlloc. Bloki z areny są zwalniane
+ * dopiero razem z areną, chyba że to ostatni blok przydzielony z bieżącej areny.
+ * @param[in] ptr : wskaźnik na blok pamięci lub NULL
+ */
+void BlockFree(void *ptr);
+
+/**
+ * Sprawdza, czy blok zaalokowany przez BlockAlloc może być współdzielony.
+ * Bloki z aren nie są współdzielone, podobnie jak żadne bloki w czasie,
+ * gdy ustawiona jest arena: wtedy zawartość trzeba skopiować.
+ * @param[in] ptr : wskaźnik na blok pamięci
+ * @return czy blok może być współdzielony.
+ */
+bool BlockCanShare(const void *ptr);
+
+/**
+ * Dodaje odwołanie do bloku zaalokowanego przez BlockAlloc, o ile może on
+ * być współdzielony (zob. BlockCanShare).
+ * @param[in] ptr : wskaźnik na blok pamięci
+ * @return czy dodano odwołanie do bloku.
+ */
+bool BlockShare(void *ptr);
+
+/**
+ * Oznacza blok jako należący do tablicy postaci kanonicznych wielomianów
+ * lub zdejmuje to oznaczenie. Nowe bloki nie są oznaczone.
+ * @param[in] ptr : wskaźnik na blok pamięci
+ * @param[in] interned : czy blok należy do tablicy
+ */
+void BlockSetInterned(void *ptr, bool interned);
+
+/**
+ * Sprawdza, czy blok należy do tablicy postaci kanonicznych wielomianów.
+ * Takiego bloku nie wolno zmieniać, nawet jeśli nie jest współdzielony.
+ * @param[in] ptr : wskaźnik na blok pamięci
+ * @return czy blok jest oznaczony.
+ */
+bool BlockIsInterned(const void *ptr);
+
+/**
+ * Sprawdza, czy do bloku jest więcej niż jedno odwołanie.
+ * Współdzielonego bloku nie wolno zmieniać ani zwalniać funkcją BlockFree.
+ * @param[in] ptr : wskaźnik na blok pamięci
+ * @return czy blok jest współdzielony.
+ */
+bool BlockIsShared(const void *ptr);
+
+/**
+ * Usuwa odwołanie do bloku zaalokowanego przez BlockAlloc.
+ * Jeśli było to ostatnie odwołanie, blok pozostaje zaalokowany,
+ * a wołający powinien zwolnić jego zawartość i sam blok funkcją BlockFree.
+ * @param[in] ptr : wskaźnik na blok pamięci
+ * @return czy było to ostatnie odwołanie do bloku.
+ */
+bool BlockRelease(void *ptr);
+
+/**
+ * To jest struktura przechowująca statystyki puli małych bloków bieżącego wątku.
+ * Bloki do wielkości 256 bajtów są po zwolnieniu odkładane na listę wolnych bloków
+ * swojej klasy wielkości i ponownie wydawane przez BlockAlloc.
+ */
+typedef struct BlockPoolStats {
+    size_t hits; ///< liczba bloków wydanych z listy wolnych bloków
+    size_t misses; ///< liczba bloków, które trzeba było zaalokować na stercie
+} BlockPoolStats;
+
+/**
+ * Zwraca statystyki puli małych bloków bieżącego wątku.
+ * @return statystyki puli.
+ */
+BlockPoolStats BlockPoolGetStats(void);
+
+/**
+ * Zwalnia wszystkie wolne bloki przechowywane w puli bieżącego wątku.
+ */
+void BlockPoolRelease(void);
+
 #endif //MEMORY_H
\ No newline at end of file
@@ -0,0 +1,965 @@
+/** @file
+  Implementacja modułu mnożącego wielomiany.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <stdlib.h>
+#include "mul.h"
+#include "memory.h"
+#include "leaf.h"
+#include "canon.h"
+#include "pool.h"
+
+/** Maksymalna liczba zmiennych, dla której próbujemy podstawienia Kroneckera. */
+#define DENSE_MAX_VARS 8
+
+/** Maksymalna długość tablicy współczynników wyniku podstawienia Kroneckera. */
+#define DENSE_MAX_LENGTH (1 << 22)
+
+/** Minimalna gęstość obu czynników, od której wybieramy podstawienie Kroneckera. */
+#define DENSE_MIN_DENSITY 0.5
+
+/** Minimalna liczba jednomianów obu czynników, od której opłaca się pakowanie. */
+#define DENSE_MIN_TERMS 16
+
+/** Ograniczenie na liczbę jednomianów mniejszego czynnika w mnożeniu wielomianów liściowych. */
+#define MUL_LEAF_MAX_SIZE (1UL << 32)
+
+/** Liczba liczb pierwszych, modulo których liczymy transformaty. */
+#define NTT_PRIMES 3
+
+/**
+ * Liczby pierwsze postaci @f$c \cdot 2^{40} + 1@f$ mniejsze od @f$2^{62}@f$ wraz z pierwiastkami pierwotnymi.
+ * Iloczyn tych liczb przekracza @f$2^{185}@f$, więc wyznacza jednoznacznie każdy współczynnik
+ * splotu tablic liczb mniejszych od @f$2^{64}@f$ o długości mniejszej niż @f$2^{57}@f$.
+ */
+static const unsigned long ntt_primes[NTT_PRIMES][2] = {
+    {4611615649683210241UL, 11},
+    {4611613450659954689UL, 3},
+    {4611549678985543681UL, 19},
+};
+
+/** Największy wykładnik dwójki dzielący @f$p - 1@f$ dla wszystkich liczb z ntt_primes. */
+#define NTT_MAX_LOG 40
+
+/** Metoda mnożenia wybrana przez MulSetMode. */
+static MulMode mul_mode = MUL_AUTO;
+
+/** Długość tablic, od której mnożymy je algorytmem Karatsuby. */
+static size_t karatsuba_cutoff = KARATSUBA_DEFAULT_CUTOFF;
+
+/** Długość tablic, od której mnożymy je szybką transformatą teorioliczbową. */
+static size_t ntt_cutoff = NTT_DEFAULT_CUTOFF;
+
+/** Liczba par jednomianów czynników, od której dzielimy mnożenie między wątki. */
+static size_t parallel_cutoff = PARALLEL_DEFAULT_CUTOFF;
+
+void MulSetMode(MulMode mode) {
+    mul_mode = mode;
+}
+
+void MulSetKaratsubaCutoff(size_t cutoff) {
+    karatsuba_cutoff = cutoff < 2 ? 2 : cutoff;
+}
+
+void MulSetNttCutoff(size_t cutoff) {
+    ntt_cutoff = cutoff < 1 ? 1 : cutoff;
+}
+
+void MulSetParallelCutoff(size_t cutoff) {
+    parallel_cutoff = cutoff < 1 ? 1 : cutoff;
+}
+
+/**
+ * To jest struktura przechowująca element kopca.
+ * Odpowiada iloczynowi jednomianu @p i z pierwszego czynnika
+ * i jednomianu @p j z drugiego czynnika.
+ */
+typedef struct HeapNode {
+    long long exp; ///< wykładnik iloczynu, klucz kopca
+    size_t i; ///< indeks jednomianu w pierwszym czynniku
+    size_t j; ///< indeks jednomianu w drugim czynniku
+} HeapNode;
+
+/**
+ * Wstawia element do kopca minimalnego.
+ * @param[in] heap : kopiec
+ * @param[in] size : wskaźnik na rozmiar kopca
+ * @param[in] node : wstawiany element
+ */
+static void HeapPush(HeapNode *heap, size_t *size, HeapNode node) {
+    size_t k = (*size)++;
+    while (k > 0) {
+        size_t parent = (k - 1) / 2;
+        if (heap[parent].exp <= node.exp)
+            break;
+        heap[k] = heap[parent];
+        k = parent;
+    }
+    heap[k] = node;
+}
+
+/**
+ * Usuwa najmniejszy element z kopca minimalnego.
+ * @param[in] heap : kopiec
+ * @param[in] size : wskaźnik na rozmiar kopca
+ * @return usunięty element
+ */
+static HeapNode HeapPop(HeapNode *heap, size_t *size) {
+    HeapNode top = heap[0];
+    HeapNode last = heap[--(*size)];
+    size_t k = 0;
+    while (true) {
+        size_t child = 2 * k + 1;
+        if (child >= *size)
+            break;
+        if (child + 1 < *size && heap[child + 1].exp < heap[child].exp)
+            child++;
+        if (last.exp <= heap[child].exp)
+            break;
+        heap[k] = heap[child];
+        k = child;
+    }
+    heap[k] = last;
+    return top;
+}
+
+/**
+ * Dopisuje wielomian do rosnącej tablicy składników sumy.
+ * W razie potrzeby powiększa tablicę.
+ * @param[in] terms : wskaźnik na tablicę składników
+ * @param[in] count : wskaźnik na liczbę składników w tablicy
+ * @param[in] capacity : wskaźnik na pojemność tablicy
+ * @param[in] term : składnik
+ */
+static void Collect(Poly **terms, size_t *count, size_t *capacity, Poly term) {
+    if (*count >= *capacity) {
+        *capacity *= 2;
+        *terms = SafeRealloc(*terms, *capacity * sizeof(Poly));
+    }
+    (*terms)[(*count)++] = term;
+}
+
+/**
+ * Dopisuje jednomian na koniec tablicy wyniku, jeśli jego współczynnik
+ * jest niezerowy. W razie potrzeby powiększa tablicę.
+ * @param[in] arr : wskaźnik na tablicę jednomianów
+ * @param[in] size : wskaźnik na liczbę jednomianów w tablicy
+ * @param[in] capacity : wskaźnik na pojemność tablicy
+ * @param[in] coeff : współczynnik jednomianu
+ * @param[in] exp : wykładnik jednomianu
+ */
+static void Emit(Mono **arr, size_t *size, size_t *capacity, Poly coeff, poly_exp_t exp) {
+    if (PolyIsZero(&coeff))
+        return;
+    if (*size >= *capacity) {
+        *capacity *= 2;
+        *arr = BlockRealloc(*arr, *capacity * sizeof(Mono));
+    }
+    (*arr)[*size].p = coeff;
+    (*arr)[*size].exp = exp;
+    (*size)++;
+}
+
+/**
+ * Wstawia klucz do kopca minimalnego liczb.
+ * @param[in] heap : kopiec
+ * @param[in] size : wskaźnik na rozmiar kopca
+ * @param[in] key : wstawiany klucz
+ */
+static void KeyHeapPush(unsigned long *heap, size_t *size, unsigned long key) {
+    size_t k = (*size)++;
+    while (k > 0) {
+        size_t parent = (k - 1) / 2;
+        if (heap[parent] <= key)
+            break;
+        heap[k] = heap[parent];
+        k = parent;
+    }
+    heap[k] = key;
+}
+
+/**
+ * Usuwa najmniejszy klucz z kopca minimalnego liczb.
+ * @param[in] heap : kopiec
+ * @param[in] size : wskaźnik na rozmiar kopca
+ * @return usunięty klucz
+ */
+static unsigned long KeyHeapPop(unsigned long *heap, size_t *size) {
+    unsigned long top = heap[0];
+    unsigned long last = heap[--(*size)];
+    size_t k = 0;
+    while (true) {
+        size_t child = 2 * k + 1;
+        if (child >= *size)
+            break;
+        if (child + 1 < *size && heap[child + 1] < heap[child])
+            child++;
+        if (last <= heap[child])
+            break;
+        heap[k] = heap[child];
+        k = child;
+    }
+    heap[k] = last;
+    return top;
+}
+
+/**
+ * Mnoży dwa wielomiany liściowe metodą Johnsona. Czynniki są czytane wielokrotnie,
+ * więc są już skopiowane do ciągłych tablic wykładników i współczynników,
+ * a iloczyny sumujemy jako liczby, bez tworzenia wielomianów.
+ * Element kopca to jedna liczba: wykładnik iloczynu w starszych 32 bitach
+ * i indeks jednomianu pierwszego czynnika w młodszych, a indeksy jednomianów
+ * drugiego czynnika są trzymane osobno dla każdego jednomianu pierwszego.
+ * Zwalnia tablice obu czynników.
+ * @param[in] a : mniejszy czynnik w postaci dwóch tablic
+ * @param[in] b : większy czynnik w postaci dwóch tablic
+ * @return iloczyn czynników
+ */
+static Poly MulHeapLeaf(Leaf a, Leaf b) {
+    size_t heap_size = 0;
+    unsigned long *heap = (unsigned long *) SafeMalloc(a.size * sizeof(unsigned long));
+    size_t *next = (size_t *) SafeMalloc(a.size * sizeof(size_t));
+    KeyHeapPush(heap, &heap_size, ((unsigned long) a.exp[0] + b.exp[0]) << 32);
+    next[0] = 0;
+
+    size_t size = 0;
+    size_t capacity = a.size;
+    Mono *arr = (Mono *) BlockAlloc(capacity * sizeof(Mono));
+
+    unsigned long acc = 0;
+    unsigned long acc_exp = heap[0] >> 32;
+    while (heap_size > 0) {
+        unsigned long key = KeyHeapPop(heap, &heap_size);
+        unsigned long exp = key >> 32;
+        size_t i = key & 0xffffffffUL, j = next[i];
+        if (exp != acc_exp) {
+            Emit(&arr, &size, &capacity, PolyFromCoeff((poly_coeff_t) acc), (poly_exp_t) acc_exp);
+            acc = 0;
+            acc_exp = exp;
+        }
+        acc += a.coeff[i] * b.coeff[j];
+
+        if (j == 0 && i + 1 < a.size) {
+            next[i + 1] = 0;
+            KeyHeapPush(heap, &heap_size, ((unsigned long) a.exp[i + 1] + b.exp[0]) << 32 | (i + 1));
+        }
+        if (j + 1 < b.size) {
+            next[i] = j + 1;
+            KeyHeapPush(heap, &heap_size, ((unsigned long) a.exp[i] + b.exp[j + 1]) << 32 | i);
+        }
+    }
+    Emit(&arr, &size, &capacity, PolyFromCoeff((poly_coeff_t) acc), (poly_exp_t) acc_exp);
+    free(heap);
+    free(next);
+    LeafFree(&a);
+    LeafFree(&b);
+    return PolyFinish(arr, size);
+}
+
+Poly MulHeap(const Poly *p, const Poly *q) {
+    assert(p != NULL && q != NULL);
+    assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
+
+    //Kopiec ma co najwyżej tyle elementów, ile jednomianów ma pierwszy czynnik, więc wybieramy mniejszy.
+    if (p->size > q->size) {
+        const Poly *temp = p;
+        p = q;
+        q = temp;
+    }
+
+    //Czy czynniki są liściowe, sprawdzamy przy kopiowaniu ich do tablic.
+    //Indeks jednomianu mniejszego czynnika musi się zmieścić w 32 bitach klucza kopca.
+    Leaf a, b;
+    if (p->size < MUL_LEAF_MAX_SIZE && LeafLoad(p, &a)) {
+        if (LeafLoad(q, &b))
+            return MulHeapLeaf(a, b);
+        LeafFree(&a);
+    }
+
+    size_t heap_size = 0;
+    HeapNode *heap = (HeapNode *) SafeMalloc(p->size * sizeof(HeapNode));
+    HeapPush(heap, &heap_size, (HeapNode) {.exp = (long long) p->arr[0].exp + q->arr[0].exp, .i = 0, .j = 0});
+
+    size_t size = 0;
+    size_t capacity = p->size;
+    Mono *arr = (Mono *) BlockAlloc(capacity * sizeof(Mono));
+
+    //Iloczyny o tym samym wykładniku zbieramy i sumujemy naraz.
+    size_t count = 0;
+    size_t terms_capacity = 4;
+    Poly *terms = (Poly *) SafeMalloc(terms_capacity * sizeof(Poly));
+    long long acc_exp = heap[0].exp;
+
+    //Jednomiany są posortowane, więc iloczyn (i, j + 1) nie jest mniejszy od (i, j),
+    //a (i + 1, 0) nie jest mniejszy od (i, 0). Wystarczy dokładać następników zdjętego elementu.
+    while (heap_size > 0) {
+        HeapNode node = HeapPop(heap, &heap_size);
+        if (node.exp != acc_exp) {
+            Emit(&arr, &size, &capacity, PolySumManyOwn(count, terms), (poly_exp_t) acc_exp);
+            count = 0;
+            acc_exp = node.exp;
+        }
+
+        Collect(&terms, &count, &terms_capacity, PolyMul(&p->arr[node.i].p, &q->arr[node.j].p));
+
+        if (node.j == 0 && node.i + 1 < p->size)
+            HeapPush(heap, &heap_size, (HeapNode) {.exp = (long long) p->arr[node.i + 1].exp + q->arr[0].exp,
+                                                   .i = node.i + 1, .j = 0});
+        if (node.j + 1 < q->size)
+            HeapPush(heap, &heap_size, (HeapNode) {.exp = (long long) p->arr[node.i].exp + q->arr[node.j + 1].exp,
+                                                   .i = node.i, .j = node.j + 1});
+    }
+    Emit(&arr, &size, &capacity, PolySumManyOwn(count, terms), (poly_exp_t) acc_exp);
+    free(terms);
+    free(heap);
+    return PolyFinish(arr, size);
+}
+
+/**
+ * To jest struktura opisująca kształt wielomianu:
+ * stopnie ze względu na kolejne zmienne oraz liczbę niezerowych współczynników liczbowych.
+ */
+typedef struct Shape {
+    size_t vars; ///< liczba zmiennych
+    long long deg[DENSE_MAX_VARS]; ///< stopnie ze względu na kolejne zmienne
+    size_t terms; ///< liczba niezerowych współczynników liczbowych
+} Shape;
+
+/**
+ * Uzupełnia kształt o zawartość wielomianu.
+ * @param[in] p : wielomian
+ * @param[in] var : indeks zmiennej wielomianu @p p
+ * @param[in] shape : uzupełniany kształt
+ * @return czy wielomian ma co najwyżej DENSE_MAX_VARS zmiennych i nieujemne wykładniki
+ */
+static bool ShapeOf(const Poly *p, size_t var, Shape *shape) {
+    if (PolyIsCoeff(p)) {
+        if (p->coeff != 0)
+            shape->terms++;
+        return true;
+    }
+    if (var >= DENSE_MAX_VARS)
+        return false;
+    if (shape->vars <= var)
+        shape->vars = var + 1;
+    for (size_t i = 0; i < p->size; i++) {
+        //Wykładniki, które przepełniły się przy wcześniejszym mnożeniu, są ujemne
+        //i nie muszą być posortowane, więc sprawdzamy każdy z nich.
+        if (p->arr[i].exp < 0)
+            return false;
+        if (shape->deg[var] < p->arr[i].exp)
+            shape->deg[var] = p->arr[i].exp;
+        if (!ShapeOf(&p->arr[i].p, var + 1, shape))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Liczy gęstość wielomianu, czyli stosunek liczby współczynników
+ * do liczby wszystkich jednomianów o stopniach nie większych niż w kształcie.
+ * @param[in] shape : kształt wielomianu
+ * @return gęstość wielomianu
+ */
+static double Density(const Shape *shape) {
+    double volume = 1;
+    for (size_t v = 0; v < shape->vars; v++)
+        volume *= (double) shape->deg[v] + 1;
+    return shape->terms / volume;
+}
+
+/**
+ * To jest struktura opisująca podstawienie Kroneckera:
+ * zmiennej @f$x_v@f$ odpowiada @f$y^{stride_v}@f$.
+ */
+typedef struct Kronecker {
+    size_t vars; ///< liczba zmiennych
+    poly_exp_t deg[DENSE_MAX_VARS]; ///< stopnie wyniku ze względu na kolejne zmienne
+    size_t stride[DENSE_MAX_VARS]; ///< wykładnik zmiennej @f$y@f$ odpowiadający zmiennej
+    size_t length; ///< długość tablicy współczynników wyniku
+} Kronecker;
+
+/**
+ * Wyznacza podstawienie Kroneckera dla iloczynu wielomianów o zadanych kształtach.
+ * Podstawienie jest różnowartościowe na jednomianach wyniku,
+ * bo stopnie wyniku nie przekraczają sumy stopni czynników.
+ * @param[in] a : kształt pierwszego czynnika
+ * @param[in] b : kształt drugiego czynnika
+ * @param[in] k : wyznaczane podstawienie
+ * @return czy tablica współczynników wyniku mieści się w limicie DENSE_MAX_LENGTH
+ */
+static bool KroneckerOf(const Shape *a, const Shape *b, Kronecker *k) {
+    k->vars = a->vars > b->vars ? a->vars : b->vars;
+    size_t length = 1;
+    for (size_t v = k->vars; v-- > 0;) {
+        //Stopnie czynników mieszczą się w poly_exp_t, więc ich suma mieści się w long long,
+        //a iloczyn dwóch liczb nie większych od DENSE_MAX_LENGTH mieści się w size_t.
+        long long deg = a->deg[v] + b->deg[v];
+        if (deg >= DENSE_MAX_LENGTH)
+            return false;
+        k->deg[v] = (poly_exp_t) deg;
+        k->stride[v] = length;
+        length *= (size_t) deg + 1;
+        if (length > DENSE_MAX_LENGTH)
+            return false;
+    }
+    k->length = length;
+    return true;
+}
+
+/**
+ * Wpisuje współczynniki wielomianu do tablicy zgodnie z podstawieniem Kroneckera.
+ * Współczynniki są przechowywane jako liczby bez znaku, żeby przepełnienia
+ * działały modulo @f$2^{64}@f$ tak jak przy zwykłym mnożeniu.
+ * @param[in] p : wielomian
+ * @param[in] var : indeks zmiennej wielomianu @p p
+ * @param[in] offset : wykładnik @f$y@f$ odpowiadający dotychczasowym zmiennym
+ * @param[in] k : podstawienie
+ * @param[in] arr : tablica współczynników
+ */
+static void Pack(const Poly *p, size_t var, size_t offset, const Kronecker *k, unsigned long *arr) {
+    if (PolyIsCoeff(p)) {
+        arr[offset] += (unsigned long) p->coeff;
+        return;
+    }
+    for (size_t i = 0; i < p->size; i++)
+        Pack(&p->arr[i].p, var + 1, offset + (size_t) p->arr[i].exp * k->stride[var], k, arr);
+}
+
+/**
+ * Odtwarza wielomian z tablicy współczynników zgodnie z podstawieniem Kroneckera.
+ * @param[in] arr : tablica współczynników
+ * @param[in] var : indeks odtwarzanej zmiennej
+ * @param[in] offset : wykładnik @f$y@f$ odpowiadający dotychczasowym zmiennym
+ * @param[in] k : podstawienie
+ * @return odtworzony wielomian
+ */
+static Poly Unpack(const unsigned long *arr, size_t var, size_t offset, const Kronecker *k) {
+    if (var == k->vars)
+        return PolyFromCoeff((poly_coeff_t) arr[offset]);
+
+    size_t size = 0;
+    size_t capacity = 1;
+    Mono *monos = (Mono *) BlockAlloc(capacity * sizeof(Mono));
+    for (poly_exp_t e = 0; e <= k->deg[var]; e++) {
+        Poly coeff = Unpack(arr, var + 1, offset + (size_t) e * k->stride[var], k);
+        Emit(&monos, &size, &capacity, coeff, e);
+    }
+    return PolyFinish(monos, size);
+}
+
+/**
+ * Mnoży dwie tablice współczynników metodą szkolną, pomijając zerowe współczynniki
+ * pierwszego czynnika. Tablica wyniku musi być wyzerowana.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość tablicy @p a
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość tablicy @p b
+ * @param[in] c : tablica wyniku o długości co najmniej @f$n + m - 1@f$
+ */
+static void KernelClassical(const unsigned long *a, size_t n, const unsigned long *b, size_t m, unsigned long *c) {
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] == 0)
+            continue;
+        for (size_t j = 0; j < m; j++)
+            c[i + j] += a[i] * b[j];
+    }
+}
+
+/**
+ * Dodaje tablicę do tablicy.
+ * @param[in] dst : tablica, do której dodajemy
+ * @param[in] src : dodawana tablica
+ * @param[in] length : długość tablicy @p src
+ */
+static void AddTo(unsigned long *dst, const unsigned long *src, size_t length) {
+    for (size_t i = 0; i < length; i++)
+        dst[i] += src[i];
+}
+
+/**
+ * Odejmuje tablicę od tablicy.
+ * @param[in] dst : tablica, od której odejmujemy
+ * @param[in] src : odejmowana tablica
+ * @param[in] length : długość tablicy @p src
+ */
+static void SubFrom(unsigned long *dst, const unsigned long *src, size_t length) {
+    for (size_t i = 0; i < length; i++)
+        dst[i] -= src[i];
+}
+
+/**
+ * Mnoży dwie tablice współczynników algorytmem Karatsuby i dodaje iloczyn do tablicy wyniku.
+ * Poniżej długości karatsuba_cutoff mnoży metodą szkolną. Mocno niezrównoważone
+ * czynniki dzieli na kawałki długości krótszego z nich.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość tablicy @p a
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość tablicy @p b
+ * @param[in] c : tablica wyniku o długości co najmniej @f$n + m - 1@f$
+ */
+static void KernelKaratsuba(const unsigned long *a, size_t n, const unsigned long *b, size_t m, unsigned long *c) {
+    if (n < m) {
+        const unsigned long *temp = a;
+        a = b;
+        b = temp;
+        size_t temp_length = n;
+        n = m;
+        m = temp_length;
+    }
+
+    if (m < karatsuba_cutoff) {
+        KernelClassical(a, n, b, m, c);
+        return;
+    }
+
+    size_t h = (n + 1) / 2;
+    if (m <= h) {
+        for (size_t offset = 0; offset < n; offset += m) {
+            size_t length = n - offset < m ? n - offset : m;
+            KernelKaratsuba(a + offset, length, b, m, c + offset);
+        }
+        return;
+    }
+
+    //a = a0 + a1 * y^h, b = b0 + b1 * y^h, a0 i b0 mają długość h.
+    //Wtedy a * b = z0 + (z1 - z0 - z2) * y^h + z2 * y^2h, gdzie z1 = (a0 + a1) * (b0 + b1).
+    size_t n1 = n - h, m1 = m - h;
+    unsigned long *buffer = (unsigned long *) SafeCalloc(2 * h + 2 * (2 * h - 1), sizeof(unsigned long));
+    unsigned long *sa = buffer;
+    unsigned long *sb = sa + h;
+    unsigned long *z0 = sb + h;
+    unsigned long *z1 = z0 + (2 * h - 1);
+
+    for (size_t i = 0; i < h; i++) {
+        sa[i] = a[i] + (i < n1 ? a[h + i] : 0);
+        sb[i] = b[i] + (i < m1 ? b[h + i] : 0);
+    }
+
+    KernelKaratsuba(a, h, b, h, z0);
+    KernelKaratsuba(sa, h, sb, h, z1);
+    SubFrom(z1, z0, 2 * h - 1);
+    AddTo(c, z0, 2 * h - 1);
+
+    //z0 nie jest już potrzebne, więc trzymamy w nim z2.
+    size_t z2_length = n1 + m1 - 1;
+    for (size_t i = 0; i < z2_length; i++)
+        z0[i] = 0;
+    KernelKaratsuba(a + h, n1, b + h, m1, z0);
+    SubFrom(z1, z0, z2_length);
+    AddTo(c + 2 * h, z0, z2_length);
+    AddTo(c + h, z1, 2 * h - 1);
+
+    free(buffer);
+}
+
+/**
+ * To jest struktura przechowująca stałe arytmetyki Montgomery'ego modulo liczba pierwsza.
+ * Dla @f$R = 2^{64}@f$ iloczyn Montgomery'ego liczb @f$a, b@f$ to @f$abR^{-1} \bmod p@f$.
+ */
+typedef struct Modulus {
+    unsigned long p; ///< liczba pierwsza mniejsza od @f$2^{62}@f$
+    unsigned long neg_inv; ///< @f$-p^{-1} \bmod 2^{64}@f$
+    unsigned long r2; ///< @f$R^2 \bmod p@f$
+} Modulus;
+
+/**
+ * Liczy iloczyn Montgomery'ego dwóch liczb mniejszych od @f$p@f$.
+ * @param[in] a : pierwsza liczba
+ * @param[in] b : druga liczba
+ * @param[in] m : moduł
+ * @return @f$abR^{-1} \bmod p@f$
+ */
+static inline unsigned long MontMul(unsigned long a, unsigned long b, const Modulus *m) {
+    unsigned __int128 t = (unsigned __int128) a * b;
+    unsigned long low = (unsigned long) t;
+    unsigned long q = low * m->neg_inv;
+    //Młodsze słowo t + qp jest zerem, więc przeniesienie powstaje dokładnie wtedy, gdy low nie jest zerem.
+    unsigned long result = (unsigned long) (t >> 64) + (unsigned long) (((unsigned __int128) q * m->p) >> 64) + (low != 0);
+    return result >= m->p ? result - m->p : result;
+}
+
+/**
+ * Zamienia liczbę na postać Montgomery'ego. Mnożenie przez liczbę w tej postaci
+ * iloczynem Montgomery'ego daje zwykły iloczyn modulo @f$p@f$.
+ * @param[in] a : liczba mniejsza od @f$p@f$
+ * @param[in] m : moduł
+ * @return @f$aR \bmod p@f$
+ */
+static inline unsigned long ToMont(unsigned long a, const Modulus *m) {
+    return MontMul(a, m->r2, m);
+}
+
+/**
+ * Dodaje dwie liczby modulo @f$p@f$.
+ * @param[in] a : pierwsza liczba mniejsza od @f$p@f$
+ * @param[in] b : druga liczba mniejsza od @f$p@f$
+ * @param[in] p : moduł
+ * @return @f$a + b \bmod p@f$
+ */
+static inline unsigned long AddMod(unsigned long a, unsigned long b, unsigned long p) {
+    unsigned long sum = a + b;
+    return sum >= p ? sum - p : sum;
+}
+
+/**
+ * Odejmuje dwie liczby modulo @f$p@f$.
+ * @param[in] a : pierwsza liczba mniejsza od @f$p@f$
+ * @param[in] b : druga liczba mniejsza od @f$p@f$
+ * @param[in] p : moduł
+ * @return @f$a - b \bmod p@f$
+ */
+static inline unsigned long SubMod(unsigned long a, unsigned long b, unsigned long p) {
+    return a >= b ? a - b : a + p - b;
+}
+
+/**
+ * Podnosi liczbę do potęgi modulo @f$p@f$.
+ * @param[in] a : podstawa mniejsza od @f$p@f$
+ * @param[in] n : wykładnik
+ * @param[in] m : moduł
+ * @return @f$a^n \bmod p@f$
+ */
+static unsigned long PowMod(unsigned long a, unsigned long n, const Modulus *m) {
+    unsigned long acc = 1;
+    a = ToMont(a, m);
+    while (n > 0) {
+        if (n % 2 == 1)
+            acc = MontMul(acc, a, m);
+        a = MontMul(a, a, m);
+        n /= 2;
+    }
+    return acc;
+}
+
+/**
+ * Wyznacza stałe arytmetyki Montgomery'ego dla liczby pierwszej.
+ * @param[in] p : liczba pierwsza mniejsza od @f$2^{62}@f$
+ * @return stałe modułu
+ */
+static Modulus ModulusOf(unsigned long p) {
+    //Metoda Newtona podwaja liczbę poprawnych bitów odwrotności w każdym kroku.
+    unsigned long inv = p;
+    for (int i = 0; i < 6; i++)
+        inv *= 2 - p * inv;
+    unsigned long r = (0UL - p) % p;
+    return (Modulus) {.p = p, .neg_inv = 0UL - inv, .r2 = (unsigned long) ((unsigned __int128) r * r % p)};
+}
+
+/**
+ * Wypełnia tablicę potęg pierwiastków z jedynki dla transformaty długości @p n.
+ * Dla każdej potęgi dwójki @f$len < n@f$ na pozycjach @f$len, \ldots, 2len - 1@f$
+ * znajdują się kolejne potęgi pierwiastka stopnia @f$2len@f$ w postaci Montgomery'ego.
+ * @param[in] root : pierwiastek z jedynki stopnia @p n
+ * @param[in] n : długość transformaty
+ * @param[in] m : moduł
+ * @param[in] table : wypełniana tablica długości @p n
+ */
+static void NttTwiddles(unsigned long root, size_t n, const Modulus *m, unsigned long *table) {
+    unsigned long w = ToMont(root, m);
+    for (size_t len = n / 2; len >= 1; len /= 2) {
+        unsigned long power = ToMont(1, m);
+        for (size_t j = 0; j < len; j++) {
+            table[len + j] = power;
+            power = MontMul(power, w, m);
+        }
+        w = MontMul(w, w, m);
+    }
+}
+
+/**
+ * Liczy transformatę w miejscu metodą Gentlemana-Sande'a.
+ * Wynik jest w kolejności odwróconych bitów indeksów.
+ * @param[in] a : tablica długości @p n
+ * @param[in] n : długość transformaty, potęga dwójki
+ * @param[in] table : potęgi pierwiastka z NttTwiddles
+ * @param[in] m : moduł
+ */
+static void NttForward(unsigned long *a, size_t n, const unsigned long *table, const Modulus *m) {
+    for (size_t len = n / 2; len >= 1; len /= 2) {
+        for (size_t i = 0; i < n; i += 2 * len) {
+            for (size_t j = 0; j < len; j++) {
+                unsigned long u = a[i + j], v = a[i + j + len];
+                a[i + j] = AddMod(u, v, m->p);
+                a[i + j + len] = MontMul(SubMod(u, v, m->p), table[len + j], m);
+            }
+        }
+    }
+}
+
+/**
+ * Liczy odwrotną transformatę w miejscu metodą Cooleya-Tukeya, bez dzielenia przez @p n.
+ * Dane wejściowe są w kolejności odwróconych bitów indeksów.
+ * @param[in] a : tablica długości @p n
+ * @param[in] n : długość transformaty, potęga dwójki
+ * @param[in] table : potęgi odwrotności pierwiastka z NttTwiddles
+ * @param[in] m : moduł
+ */
+static void NttInverse(unsigned long *a, size_t n, const unsigned long *table, const Modulus *m) {
+    for (size_t len = 1; len < n; len *= 2) {
+        for (size_t i = 0; i < n; i += 2 * len) {
+            for (size_t j = 0; j < len; j++) {
+                unsigned long u = a[i + j], v = MontMul(a[i + j + len], table[len + j], m);
+                a[i + j] = AddMod(u, v, m->p);
+                a[i + j + len] = SubMod(u, v, m->p);
+            }
+        }
+    }
+}
+
+/**
+ * Liczy splot dwóch tablic modulo liczba pierwsza.
+ * @param[in] a : pierwszy czynnik
+ * @param[in] n : długość tablicy @p a
+ * @param[in] b : drugi czynnik
+ * @param[in] m_length : długość tablicy @p b
+ * @param[in] length : długość transformaty, potęga dwójki nie mniejsza niż @f$n + m - 1@f$
+ * @param[in] prime : indeks liczby pierwszej w ntt_primes
+ * @param[in] fa : tablica pomocnicza długości @p length, w której znajdzie się wynik
+ * @param[in] fb : tablica pomocnicza długości @p length
+ * @param[in] table : tablica pomocnicza długości @p length
+ */
+static void NttConvolve(const unsigned long *a, size_t n, const unsigned long *b, size_t m_length, size_t length,
+                        int prime, unsigned long *fa, unsigned long *fb, unsigned long *table) {
+    Modulus m = ModulusOf(ntt_primes[prime][0]);
+    unsigned long p = m.p;
+    for (size_t i = 0; i < length; i++) {
+        fa[i] = i < n ? a[i] % p : 0;
+        fb[i] = i < m_length ? b[i] % p : 0;
+    }
+
+    unsigned long root = PowMod(ntt_primes[prime][1], (p - 1) / length, &m);
+    NttTwiddles(root, length, &m, table);
+    NttForward(fa, length, table, &m);
+    NttForward(fb, length, table, &m);
+    for (size_t i = 0; i < length; i++)
+        fa[i] = MontMul(fa[i], ToMont(fb[i], &m), &m);
+
+    NttTwiddles(PowMod(root, p - 2, &m), length, &m, table);
+    NttInverse(fa, length, table, &m);
+    unsigned long scale = ToMont(PowMod(length % p, p - 2, &m), &m);
+    for (size_t i = 0; i < length; i++)
+        fa[i] = MontMul(fa[i], scale, &m);
+}
+
+/**
+ * Mnoży dwie tablice współczynników szybką transformatą teorioliczbową i dodaje iloczyn
+ * do tablicy wyniku. Splot jest liczony modulo trzy liczby pierwsze z ntt_primes
+ * i odtwarzany dokładnie z chińskiego twierdzenia o resztach (algorytmem Garnera),
+ * a następnie brany modulo @f$2^{64}@f$, więc wynik jest taki sam jak w metodzie szkolnej.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość tablicy @p a
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość tablicy @p b
+ * @param[in] c : tablica wyniku o długości co najmniej @f$n + m - 1@f$
+ */
+static void KernelNtt(const unsigned long *a, size_t n, const unsigned long *b, size_t m, unsigned long *c) {
+    size_t length = 1;
+    while (length < n + m - 1)
+        length *= 2;
+    assert(length <= (1UL << NTT_MAX_LOG));
+
+    unsigned long *buffer = (unsigned long *) SafeMalloc(5 * length * sizeof(unsigned long));
+    unsigned long *r0 = buffer, *r1 = r0 + length, *fa = r1 + length, *fb = fa + length, *table = fb + length;
+
+    NttConvolve(a, n, b, m, length, 0, r0, fb, table);
+    NttConvolve(a, n, b, m, length, 1, r1, fb, table);
+    NttConvolve(a, n, b, m, length, 2, fa, fb, table);
+
+    unsigned long p0 = ntt_primes[0][0], p1 = ntt_primes[1][0], p2 = ntt_primes[2][0];
+    Modulus m1 = ModulusOf(p1), m2 = ModulusOf(p2);
+    unsigned long inv_p0 = ToMont(PowMod(p0 % p1, p1 - 2, &m1), &m1);
+    unsigned long p0_mod_p2 = ToMont(p0 % p2, &m2);
+    unsigned long inv_p0p1 = ToMont(PowMod(MontMul(p0_mod_p2, p1 % p2, &m2), p2 - 2, &m2), &m2);
+
+    //x = v0 + v1 * p0 + v2 * p0 * p1, gdzie 0 <= vi < pi, jest dokładną wartością splotu.
+    for (size_t i = 0; i < n + m - 1; i++) {
+        unsigned long v0 = r0[i];
+        unsigned long v1 = MontMul(SubMod(r1[i], v0 % p1, p1), inv_p0, &m1);
+        unsigned long x_mod_p2 = AddMod(v0 % p2, MontMul(v1 % p2, p0_mod_p2, &m2), p2);
+        unsigned long v2 = MontMul(SubMod(fa[i], x_mod_p2, p2), inv_p0p1, &m2);
+        c[i] += v0 + v1 * p0 + v2 * (p0 * p1);
+    }
+
+    free(buffer);
+}
+
+/**
+ * Mnoży dwie tablice współczynników algorytmem dobranym do ich długości
+ * i dodaje iloczyn do tablicy wyniku.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość tablicy @p a
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość tablicy @p b
+ * @param[in] c : tablica wyniku o długości co najmniej @f$n + m - 1@f$
+ */
+static void KernelProduct(const unsigned long *a, size_t n, const unsigned long *b, size_t m, unsigned long *c) {
+    if (n >= ntt_cutoff && m >= ntt_cutoff)
+        KernelNtt(a, n, b, m, c);
+    else
+        KernelKaratsuba(a, n, b, m, c);
+}
+
+/**
+ * Zwraca długość tablicy po obcięciu zer na końcu.
+ * @param[in] arr : tablica
+ * @param[in] length : długość tablicy
+ * @return długość bez końcowych zer
+ */
+static size_t Trim(const unsigned long *arr, size_t length) {
+    while (length > 0 && arr[length - 1] == 0)
+        length--;
+    return length;
+}
+
+/**
+ * Mnoży wielomiany podstawieniem Kroneckera o zadanym podstawieniu.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] k : podstawienie
+ * @return @f$p * q@f$
+ */
+static Poly MulKronecker(const Poly *p, const Poly *q, const Kronecker *k) {
+    unsigned long *a = (unsigned long *) SafeCalloc(k->length, sizeof(unsigned long));
+    unsigned long *b = (unsigned long *) SafeCalloc(k->length, sizeof(unsigned long));
+    unsigned long *c = (unsigned long *) SafeCalloc(k->length, sizeof(unsigned long));
+
+    Pack(p, 0, 0, k, a);
+    Pack(q, 0, 0, k, b);
+    size_t n = Trim(a, k->length);
+    size_t m = Trim(b, k->length);
+    if (n > 0 && m > 0)
+        KernelProduct(a, n, b, m, c);
+
+    Poly result = Unpack(c, 0, 0, k);
+    free(a);
+    free(b);
+    free(c);
+    return result;
+}
+
+/**
+ * Wyznacza podstawienie Kroneckera dla iloczynu wielomianów, o ile oba mają
+ * co najwyżej DENSE_MAX_VARS zmiennych, a wynik mieści się w limicie długości
+ * tablicy. Przy sprawdzaniu gęstości wymaga też, żeby oba czynniki były
+ * dość duże i gęste, by pakowanie się opłacało.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] check_density : czy sprawdzać rozmiar i gęstość czynników
+ * @param[out] k : wyznaczone podstawienie
+ * @return czy mnożyć podstawieniem Kroneckera
+ */
+static bool ChooseKronecker(const Poly *p, const Poly *q, bool check_density, Kronecker *k) {
+    if (check_density && p->size < DENSE_MIN_TERMS && q->size < DENSE_MIN_TERMS)
+        return false;
+
+    Shape a = {0}, b = {0};
+    if (!ShapeOf(p, 0, &a) || !ShapeOf(q, 0, &b))
+        return false;
+    if (check_density && (a.terms < DENSE_MIN_TERMS || b.terms < DENSE_MIN_TERMS))
+        return false;
+    if (check_density && (Density(&a) < DENSE_MIN_DENSITY || Density(&b) < DENSE_MIN_DENSITY))
+        return false;
+    return KroneckerOf(&a, &b, k);
+}
+
+Poly MulDense(const Poly *p, const Poly *q) {
+    assert(p != NULL && q != NULL);
+    assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
+
+    Kronecker k;
+    if (!ChooseKronecker(p, q, false, &k))
+        return MulHeap(p, q);
+    return MulKronecker(p, q, &k);
+}
+
+/** Liczba bloków iloczynu przypadających na jeden wątek, żeby wątki mogły wyrównać obciążenie. */
+#define PARALLEL_BLOCKS_PER_THREAD 4
+
+/**
+ * To jest struktura opisująca blok iloczynu: iloczyn kolejnych jednomianów
+ * jednego czynnika przez cały drugi czynnik.
+ */
+typedef struct MulBlock {
+    const Mono *monos; ///< jednomiany bloku pierwszego czynnika
+    size_t count; ///< liczba jednomianów bloku
+    const Poly *q; ///< drugi czynnik
+    Poly result; ///< iloczyn bloku przez drugi czynnik
+} MulBlock;
+
+/**
+ * Mnoży blok jednomianów przez drugi czynnik. Jest zadaniem puli wątków.
+ * @param[in,out] arg : blok iloczynu
+ */
+static void MulBlockRun(void *arg) {
+    MulBlock *block = (MulBlock *) arg;
+    //Blok pożycza jednomiany czynnika bez kopiowania. Mnożenie tylko je czyta
+    //i nie zagląda do nagłówka tablicy, więc wystarczy wskaźnik do jej środka.
+    Poly part = {.size = block->count, .arr = (Mono *) block->monos};
+    block->result = PolyMul(&part, block->q);
+}
+
+Poly MulParallel(const Poly *p, const Poly *q) {
+    assert(p != NULL && q != NULL);
+    assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
+
+    //Dzielimy większy czynnik, żeby bloków było jak najwięcej.
+    if (p->size < q->size) {
+        const Poly *temp = p;
+        p = q;
+        q = temp;
+    }
+    size_t blocks = PARALLEL_BLOCKS_PER_THREAD * PoolThreads();
+    if (blocks > p->size)
+        blocks = p->size;
+
+    MulBlock *tasks = (MulBlock *) SafeMalloc(blocks * sizeof(MulBlock));
+    TaskGroup group;
+    TaskGroupInit(&group);
+    for (size_t i = 0; i < blocks; i++) {
+        size_t begin = p->size * i / blocks, end = p->size * (i + 1) / blocks;
+        tasks[i] = (MulBlock) {.monos = p->arr + begin, .count = end - begin, .q = q, .result = PolyZero()};
+        PoolSpawn(&group, MulBlockRun, &tasks[i]);
+    }
+    PoolWait(&group);
+
+    Poly *parts = (Poly *) SafeMalloc(blocks * sizeof(Poly));
+    for (size_t i = 0; i < blocks; i++)
+        parts[i] = tasks[i].result;
+    Poly result = PolySumManyOwn(blocks, parts);
+    free(parts);
+    free(tasks);
+    return result;
+}
+
+/**
+ * Sprawdza, czy mnożenie warto podzielić między wątki. Nie dzielimy go wewnątrz
+ * zadań puli, bo wątki są już zajęte, ani przy ustawionej arenie, bo wątki
+ * robocze przydzielają bloki na stercie.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return czy mnożyć równolegle
+ */
+static bool ShouldSplit(const Poly *p, const Poly *q) {
+    return PoolThreads() > 1 && !PoolInTask() && ArenaCurrent() == NULL &&
+           (p->size > 1 || q->size > 1) && p->size * q->size >= parallel_cutoff;
+}
+
+Poly MulEngine(const Poly *p, const Poly *q) {
+    assert(p != NULL && q != NULL);
+    assert(!PolyIsCoeff(p) && !PolyIsCoeff(q));
+
+    Kronecker k;
+    if (mul_mode != MUL_SPARSE && ChooseKronecker(p, q, mul_mode == MUL_AUTO, &k))
+        return MulKronecker(p, q, &k);
+
+    //Między wątki dzielimy tylko scalanie kopcem. Bloki gęstego iloczynu
+    //mnożone osobno kosztowałyby razem dużo więcej niż jedno podstawienie Kroneckera.
+    if (ShouldSplit(p, q))
+        return MulParallel(p, q);
+    return MulHeap(p, q);
+}
@@ -0,0 +1,108 @@
+/** @file
+  Interfejs modułu mnożącego wielomiany.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef MUL_H
+#define MUL_H
+
+#include "poly.h"
+
+/** Domyślna długość tablic, od której mnożymy je algorytmem Karatsuby. */
+#define KARATSUBA_DEFAULT_CUTOFF 32
+
+/** Domyślna długość tablic, od której mnożymy je szybką transformatą teorioliczbową. */
+#define NTT_DEFAULT_CUTOFF 16384
+
+/** Domyślna liczba par jednomianów czynników, od której dzielimy mnożenie między wątki. */
+#define PARALLEL_DEFAULT_CUTOFF 4096
+
+/**
+ * To jest typ wyznaczający metodę mnożenia wielomianów.
+ */
+typedef enum MulMode {
+    MUL_AUTO, ///< metoda dobierana na podstawie gęstości czynników
+    MUL_SPARSE, ///< zawsze scalanie kopcem
+    MUL_DENSE ///< zawsze podstawienie Kroneckera, o ile wynik zmieści się w limicie
+} MulMode;
+
+/**
+ * Ustawia metodę mnożenia używaną przez PolyMul. Służy głównie do pomiarów.
+ * @param[in] mode : metoda mnożenia
+ */
+void MulSetMode(MulMode mode);
+
+/**
+ * Ustawia długość tablic współczynników, od której podstawienie Kroneckera
+ * mnoży je algorytmem Karatsuby zamiast metodą szkolną.
+ * @param[in] cutoff : długość krótszej tablicy, co najmniej 2
+ */
+void MulSetKaratsubaCutoff(size_t cutoff);
+
+/**
+ * Ustawia długość tablic współczynników, od której podstawienie Kroneckera
+ * mnoży je szybką transformatą teorioliczbową modulo trzy liczby pierwsze.
+ * Wynik jest taki sam jak przy pozostałych metodach.
+ * @param[in] cutoff : długość krótszej tablicy, co najmniej 1
+ */
+void MulSetNttCutoff(size_t cutoff);
+
+/**
+ * Ustawia liczbę par jednomianów najwyższego poziomu obu czynników, od której
+ * PolyMul dzieli mnożenie scalaniem kopcem między wątki puli, jeśli jest ich
+ * więcej niż jeden (zob. PoolSetThreads). Mniejsze iloczyny oraz iloczyny
+ * liczone podstawieniem Kroneckera są liczone w jednym wątku.
+ * @param[in] cutoff : liczba par jednomianów, co najmniej 1
+ */
+void MulSetParallelCutoff(size_t cutoff);
+
+/**
+ * Mnoży dwa wielomiany, które nie są współczynnikami, wybierając metodę
+ * zgodnie z ustawieniem z MulSetMode. Jeśli wybrane zostało scalanie kopcem,
+ * a iloczyn jest dość duży, dzieli je między wątki funkcją MulParallel.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly MulEngine(const Poly *p, const Poly *q);
+
+/**
+ * Mnoży dwa wielomiany, które nie są współczynnikami, scalając iloczyny
+ * jednomianów kopcem (metoda Johnsona). Jednomiany wyniku powstają od razu
+ * w kolejności rosnących wykładników, a iloczyny o równych wykładnikach
+ * są sumowane na bieżąco, więc pamięć pomocnicza zależy tylko od rozmiaru
+ * mniejszego z czynników i rozmiaru wyniku.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly MulHeap(const Poly *p, const Poly *q);
+
+/**
+ * Mnoży dwa wielomiany, które nie są współczynnikami, podstawieniem Kroneckera.
+ * Wielomiany wielu zmiennych są pakowane do ciągłych tablic współczynników
+ * jednej zmiennej, mnożone szybką transformatą teorioliczbową, algorytmem
+ * Karatsuby lub metodą szkolną
+ * i rozpakowywane z powrotem do postaci rekurencyjnej.
+ * Jeśli wynik nie mieści się w limicie długości tablicy, mnoży scalaniem kopcem.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly MulDense(const Poly *p, const Poly *q);
+
+/**
+ * Mnoży dwa wielomiany, które nie są współczynnikami, w wielu wątkach.
+ * Większy czynnik jest dzielony na bloki kolejnych jednomianów, iloczyny
+ * bloków przez drugi czynnik są liczone jako zadania puli wątków,
+ * a na koniec sumowane funkcją PolySumManyOwn.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly MulParallel(const Poly *p, const Poly *q);
+
+#endif //MUL_H
@@ -9,59 +9,11 @@
 #include "parser.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <errno.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 #include "memory.h"
-
-/**
- * Sprawdza, czy wczytane polecenie ma strukturę wielomianu.
- * Konkretnie, czy nawiasy są ustawione poprawnie oraz czy linia zawiera tylko dozwolone znaki.
- * Sprawdza też, czy też, czy dwa sąsiednie znaki są poprawne.
- * @param[in] c: polecenie
- * @return wartość logiczna stwierdzająca, czy wczytanie polecenie ma strukturę wielomianu.
- */
-static bool IsCorrect(char *c) {
-    int open = 0, close = 0, coma = 0;
-    while (*c != '\0') {
-        bool okay = false;
-        char *z = c + 1;
-        if (*c == '\n' || isdigit(*c))
-            okay = true;
-
-        if (*c == '+' && *z == '(')
-            okay = true;
-
-        if (*c == '-' && isdigit(*z))
-            okay = true;
-
-        if (*c == '(' && (isdigit(*z) || *z == '-' || *z == '(')) {
-            okay = true;
-            open++;
-        }
-
-        if (*c == ')' && (*z == '+' || *z == '\n' || *z == '\0' || *z == ')' || *z == ',')) {
-            okay = true;
-            close++;
-            if (*(c + 1) == '(') {
-                return false;
-            }
-        }
-
-        if (*c == ',' && (isdigit(*z) || *z == '-' || *z == '+')) {
-            okay = true;
-            coma++;
-            if (coma > open) return false;
-        }
-
-        if (!okay || open < close)
-            return false;
-
-        c++;
-    }
-
-    return open == close;
-}
+#include "pool.h"
 
 /**
  * Wypisuje wielomian.
@@ -80,132 +32,403 @@ static void PolyPrint(const Poly *p) {
 
 }
 
+/** Początkowa pojemność tablic parsera: jednomianów i otwartych jednomianów. */
+#define PARSE_INITIAL_CAPACITY 16
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/** Czy cyfry są wczytywane po osiem naraz w jednym słowie 64-bitowym. */
+#define SCAN_SWAR 1
+#else
+/** Czy cyfry są wczytywane po osiem naraz w jednym słowie 64-bitowym. */
+#define SCAN_SWAR 0
+#endif
+
+/** Słowo 64-bitowe, którego każdy bajt ma wartość @p b. */
+#define SCAN_BYTES(b) (0x0101010101010101ULL * (b))
+
+/**
+ * Wylicza wartość liczby ośmiocyfrowej zapisanej na kolejnych bajtach słowa.
+ * @param[in] digits : słowo, którego bajty od najmłodszego to wartości cyfr
+ * od 0 do 9, od najbardziej znaczącej
+ * @return wartość liczby
+ */
+static inline unsigned long ScanEightDigits(unsigned long long digits) {
+    //Łączymy sąsiednie cyfry w liczby dwucyfrowe, te w czterocyfrowe, a te w wynik.
+    digits = digits * 10 + (digits >> 8);
+    digits = ((digits & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)) +
+              ((digits >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))) >> 32;
+    return (unsigned long) digits;
+}
+
 /**
- * Sprawdza, czy słowo jest poprawnym współczynnikiem ze względu na treść zadania.
- * @param[in] word: słowo
- * @return wartość logiczna stwierdzająca, czy słowo jest poprawnym współczynnikiem.
+ * Wczytuje ciąg cyfr dziesiętnych jako liczbę bez znaku nie większą niż @p limit.
+ * Dopóki przed końcem wiersza mieści się słowo 64-bitowe złożone z samych
+ * cyfr, cyfry są rozpoznawane i łączone po osiem naraz (SWAR), a przepełnienie
+ * jest sprawdzane raz na całe słowo. Resztę cyfr, a także całe krótkie liczby,
+ * które nie mają czwartej cyfry, wczytujemy pojedynczo.
+ * @param[in,out] c : wskaźnik na pierwszą cyfrę, przesuwany za ostatnią wczytaną cyfrę
+ * @param[in] end : koniec wiersza, za który nie wolno czytać
+ * @param[in] limit : największa dopuszczalna wartość
+ * @param[out] value : wczytana wartość
+ * @return czy wczytano co najmniej jedną cyfrę i wartość nie przekracza @p limit
+ */
+static inline bool ScanDigits(const char **c, const char *end, unsigned long limit, unsigned long *value) {
+    const char *p = *c;
+    unsigned long x = 0;
+#if SCAN_SWAR
+    while (end - p >= 8 && isdigit(p[3])) {
+        unsigned long long word;
+        memcpy(&word, p, sizeof(word));
+        //Bajt jest cyfrą, gdy ma starszą połówkę 3 i po dodaniu 6 nadal ją ma.
+        unsigned long long other = ((word & SCAN_BYTES(0xF0)) ^ SCAN_BYTES(0x30)) |
+                                   (((word + SCAN_BYTES(0x06)) & SCAN_BYTES(0xF0)) ^ SCAN_BYTES(0x30));
+        if (other != 0)
+            break;
+        if (__builtin_mul_overflow(x, 100000000UL, &x) ||
+            __builtin_add_overflow(x, ScanEightDigits(word - SCAN_BYTES(0x30)), &x) || x > limit)
+            return false;
+        p += 8;
+    }
+#else
+    (void) end;
+#endif
+    if (p == *c && !isdigit(*p))
+        return false;
+    while (isdigit(*p)) {
+        unsigned long digit = (unsigned long) (*p - '0');
+        if (x > limit / 10 || (x == limit / 10 && digit > limit % 10))
+            return false;
+        x = x * 10 + digit;
+        p++;
+    }
+    *c = p;
+    *value = x;
+    return true;
+}
+
+/**
+ * Wczytuje współczynnik: opcjonalny znak '-' i co najmniej jedną cyfrę,
+ * z wartością mieszczącą się w typie poly_coeff_t.
+ * @param[in,out] c : wskaźnik na początek współczynnika, przesuwany za jego koniec
+ * @param[in] end : koniec wiersza, za który nie wolno czytać
+ * @param[out] coeff : wczytany współczynnik
+ * @return czy współczynnik jest poprawny
  */
-static bool IsCoeff(const char *word) {
-    errno = 0;
-    char *endPtr = NULL;
-    strtol(word, &endPtr, 10);
-    bool okEndPtr = *endPtr == ',' || *endPtr == '\n' || *endPtr == '\0';
-    bool okFirstCharacter = isdigit(word[0]) || word[0] == '-';
-    return errno != ERANGE && okEndPtr && okFirstCharacter;
+static bool ScanCoeff(const char **c, const char *end, poly_coeff_t *coeff) {
+    bool negative = **c == '-';
+    *c += negative;
+    unsigned long x;
+    if (!ScanDigits(c, end, negative ? (unsigned long) LONG_MAX + 1 : LONG_MAX, &x))
+        return false;
+    *coeff = (poly_coeff_t) (negative ? 0 - x : x);
+    return true;
 }
 
 /**
- * Sprawdza, czy słowo jest poprawnym wykładnikiem ze względu na treść zadania.
- * @param[in] word: słowo
- * @return wartość logiczna stwierdzająca, czy słowo jest poprawnym wykładnikiem.
+ * Wczytuje wykładnik: co najmniej jedną cyfrę, z wartością z przedziału
+ * [0, INT_MAX]. Znak '-' jest dopuszczalny tylko przed zerem.
+ * @param[in,out] c : wskaźnik na początek wykładnika, przesuwany za jego koniec
+ * @param[in] end : koniec wiersza, za który nie wolno czytać
+ * @param[out] exp : wczytany wykładnik
+ * @return czy wykładnik jest poprawny
  */
-static bool IsExp(const char *word) {
-    errno = 0;
-    char *endPtr = NULL;
-    long x = strtol(word, &endPtr, 10);
-    bool okRange = !(x > 2147483647 || x < 0);
-    bool okEndPtr = (*endPtr == ')' || *endPtr == '\n' || *endPtr == '\0');
-    bool okFirstCharacter = isdigit(word[0]) || word[0] == '-';
-    return errno != ERANGE && okRange && okEndPtr && okFirstCharacter;
+static bool ScanExp(const char **c, const char *end, poly_exp_t *exp) {
+    bool negative = **c == '-';
+    *c += negative;
+    unsigned long x;
+    if (!ScanDigits(c, end, negative ? 0 : INT_MAX, &x))
+        return false;
+    *exp = (poly_exp_t) x;
+    return true;
 }
 
 /**
- * Przetwarza słowo na wielomian, który jest współczynnikiem, zakładając, że słowo jest poprawnym współczynnikiem.
- * Zmienia też przekazany wskaźnik na wskaźnik wskazujący na ostatni niewczytany znak.
- * @param[in] word: słowo.
- * @param[in] endPtr: wskaźnik na wskaźnik na znak.
- * @return wielomian będący współczynnikiem przetworzonym ze słowa.
+ * Zwalnia tablicę jednomianów razem z ich współczynnikami.
+ * @param[in] monos: tablica jednomianów.
+ * @param[in] count: liczba jednomianów.
  */
-static Poly WordToCoeff(const char *word, char **endPtr) {
-    long x = strtol(word, endPtr, 10);
-    return PolyFromCoeff(x);
+static void DestroyMonos(Mono *monos, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        PolyDestroy(&monos[i].p);
+    free(monos);
 }
 
 /**
- * Funkcja parsująca słowo na wielomian. Ustawia *endPtr na ostatni niewczytany znak.
+ * Wczytuje wielomian jednym przejściem, bez rekurencji, i zwraca jednomiany
+ * najwyższego poziomu. Jednomiany wszystkich poziomów leżą w jednej tablicy:
+ * dla każdego otwartego jednomianu pamiętamy, od którego miejsca tablicy
+ * zaczynają się jednomiany jego współczynnika. Po wczytaniu ostatniego z nich
+ * współczynnik jest tworzony funkcją PolyAddMonos, która rozpoznaje
+ * posortowane ciągi jednomianów w czasie liniowym, a jego jednomiany są
+ * zdejmowane z tablicy. Wielomian będący współczynnikiem jest zwracany jako
+ * jeden jednomian o wykładniku zero.
+ *
+ * Wielomian jest poprawny, jeśli jest współczynnikiem (opcjonalny znak '-'
+ * i cyfry, w zakresie poly_coeff_t) albo ciągiem jednomianów (p,exp)
+ * połączonych znakami '+', gdzie p jest poprawnym wielomianem, a exp
+ * wykładnikiem z przedziału [0, INT_MAX]. Po wielomianie musi wystąpić znak
+ * nowej linii lub '\0'.
  * @param[in] word: słowo
- * @param[in] correct: wskaźnik na wartość logiczną, która mówi, czy wielomian jest poprawny.
- * @param[in] endPtr: wskaźnik na wskaźnik, który będzie ustawiony na wskaźnik na pierwszy niewczytany znak.
- * @return wielomian zbudowany z wczytanego słowa.
+ * @param[in] end: koniec wiersza, za który nie wolno czytać.
+ * @param[in] monos_only: czy wielomian musi być ciągiem jednomianów.
+ * @param[out] count: liczba jednomianów najwyższego poziomu.
+ * @return tablica jednomianów zaalokowana na stercie lub NULL, jeśli wielomian jest niepoprawny.
  */
-static Poly ParsePoly(char *word, bool *correct, char **endPtr) {
+static Mono *ParseMonos(const char *word, const char *end, bool monos_only, size_t *count) {
+    const char *c = word;
+    size_t size = 0, capacity = PARSE_INITIAL_CAPACITY;
+    Mono *monos = (Mono *) SafeMalloc(capacity * sizeof(Mono));
+    size_t depth = 0, bases_capacity = PARSE_INITIAL_CAPACITY;
+    size_t *bases = (size_t *) SafeMalloc(bases_capacity * sizeof(size_t));
+    Poly value = PolyZero();
+    bool correct = !monos_only || *c == '(';
+
+    while (correct) {
+        //Otwieramy jednomiany aż do najgłębszego współczynnika.
+        while (*c == '(') {
+            if (depth == bases_capacity) {
+                bases_capacity *= 2;
+                bases = (size_t *) SafeRealloc(bases, bases_capacity * sizeof(size_t));
+            }
+            bases[depth++] = size;
+            c++;
+        }
+        poly_coeff_t coeff;
+        if (!ScanCoeff(&c, end, &coeff)) {
+            correct = false;
+            break;
+        }
+        value = PolyFromCoeff(coeff);
 
-    if (*correct == false)
-        return PolyZero();
+        //Zamykamy jednomiany, dopóki po nich nie następuje znak '+'.
+        while (true) {
+            if (depth == 0) {
+                correct = *c == '\n' || *c == '\0';
+                break;
+            }
+            poly_exp_t exp;
+            if (*c++ != ',' || !ScanExp(&c, end, &exp) || *c++ != ')') {
+                correct = false;
+                break;
+            }
+            if (size == capacity) {
+                capacity *= 2;
+                monos = (Mono *) SafeRealloc(monos, capacity * sizeof(Mono));
+            }
+            monos[size++] = (Mono) {.p = value, .exp = exp};
+            value = PolyZero();
+            depth--;
+
+            if (*c == '+')
+                break;
+            if (depth == 0) {
+                correct = *c == '\n' || *c == '\0';
+                break;
+            }
+            if (*c != ',') {
+                correct = false;
+                break;
+            }
+            size_t base = bases[depth - 1];
+            value = PolyAddMonos(size - base, monos + base);
+            size = base;
+        }
 
-    if (IsCoeff(word))
-        return WordToCoeff(word, endPtr);
+        if (!correct || *c != '+')
+            break;
+        if (*++c != '(')
+            correct = false;
+    }
+
+    free(bases);
+    if (!correct) {
+        PolyDestroy(&value);
+        DestroyMonos(monos, size);
+        *count = 0;
+        return NULL;
+    }
+    //Wielomian będący współczynnikiem nie otworzył żadnego jednomianu.
+    if (size == 0 && !PolyIsZero(&value))
+        monos[size++] = (Mono) {.p = value, .exp = 0};
+    *count = size;
+    return monos;
+}
 
-    if (word[0] != '(' || word[1] == ',') {
-        *correct = false;
-        *endPtr = word;
+/**
+ * Wczytuje wielomian z wiersza.
+ * @param[in] word: wiersz
+ * @param[in] end: koniec wiersza.
+ * @param[in] correct: wskaźnik na wartość logiczną, która mówi, czy wielomian jest poprawny.
+ * @return wielomian zbudowany z wczytanego wiersza.
+ */
+static Poly ParsePoly(const char *word, const char *end, bool *correct) {
+    size_t count = 0;
+    Mono *monos = ParseMonos(word, end, false, &count);
+    *correct = monos != NULL;
+    if (monos == NULL)
         return PolyZero();
-    }
-
-    size_t number_of_monos = 0;
-    size_t capacity = 1;
-    Mono *monos = (Mono *) SafeMalloc(capacity * sizeof(Mono));
+    return PolyOwnMonos(count, monos);
+}
 
-    while (true) {
-        char *temp = NULL;
-        char *temp2 = NULL;
+/** Długość wiersza, od której wielomian jest wczytywany w wielu wątkach. */
+#define PARSE_PARALLEL_MIN (1 << 18)
 
-        if (number_of_monos >= capacity) {
-            capacity *= 2;
-            monos = SafeRealloc(monos, capacity * sizeof(Mono));
-        }
+/** Liczba fragmentów wiersza przypadających na jeden wątek. */
+#define PARSE_SEGMENTS_PER_THREAD 4
 
-        monos[number_of_monos].p = ParsePoly(word + 1, correct, &temp);
+/**
+ * To jest struktura opisująca fragment wiersza przy szukaniu znaków '+'
+ * rozdzielających jednomiany najwyższego poziomu.
+ */
+typedef struct ParseSegment {
+    const char *begin; ///< początek fragmentu
+    const char *end; ///< koniec fragmentu
+    long depth; ///< zmiana głębokości nawiasów we fragmencie, a potem głębokość na jego początku
+    char *split; ///< pierwszy znak '+' na głębokości zero we fragmencie lub NULL
+} ParseSegment;
 
-        if (*correct == false) {
-            free(monos);
-            *endPtr = temp;
-            return PolyZero();
-        }
+/**
+ * To jest struktura opisująca ciąg jednomianów najwyższego poziomu wczytywany przez jeden wątek.
+ */
+typedef struct ParseChunk {
+    char *text; ///< początek ciągu, zakończonego znakiem '\0' albo '\n'
+    const char *end; ///< koniec wiersza
+    Mono *monos; ///< wczytane jednomiany
+    size_t count; ///< liczba wczytanych jednomianów
+    bool correct; ///< czy ciąg jest poprawny
+} ParseChunk;
 
-        if (*temp != ',') {
-            *correct = false;
-            *endPtr = temp;
-            free(monos);
-            return PolyZero();
-        }
-        temp++;
+/**
+ * Wylicza zmianę głębokości nawiasów we fragmencie. Jest zadaniem puli wątków.
+ * @param[in,out] arg : fragment
+ */
+static void SegmentDepthRun(void *arg) {
+    ParseSegment *segment = (ParseSegment *) arg;
+    long depth = 0;
+    for (const char *c = segment->begin; c < segment->end; c++)
+        depth += (*c == '(') - (*c == ')');
+    segment->depth = depth;
+}
 
-        if (!IsExp(temp)) {
-            *correct = false;
-            PolyDestroy(&monos[number_of_monos].p);
-            free(monos);
-            return PolyZero();
+/**
+ * Szuka pierwszego znaku '+' na głębokości zero we fragmencie, znając głębokość
+ * na jego początku. Jest zadaniem puli wątków.
+ * @param[in,out] arg : fragment
+ */
+static void SegmentSplitRun(void *arg) {
+    ParseSegment *segment = (ParseSegment *) arg;
+    long depth = segment->depth;
+    segment->split = NULL;
+    for (const char *c = segment->begin; c < segment->end; c++) {
+        if (*c == '+' && depth == 0) {
+            segment->split = (char *) c;
+            return;
         }
+        depth += (*c == '(') - (*c == ')');
+    }
+}
 
-        monos[number_of_monos].exp = strtol(temp, &temp2, 10);
-
-        number_of_monos++;
-        *endPtr = temp2;
+/**
+ * Wczytuje ciąg jednomianów. Jest zadaniem puli wątków.
+ * @param[in,out] arg : ciąg jednomianów
+ */
+static void ChunkParseRun(void *arg) {
+    ParseChunk *chunk = (ParseChunk *) arg;
+    chunk->monos = ParseMonos(chunk->text, chunk->end, true, &chunk->count);
+    chunk->correct = chunk->monos != NULL;
+}
 
-        if (**endPtr != ')') {
-            *correct = false;
-            free(monos);
-            return PolyZero();
+/**
+ * Wczytuje wielomian z długiego wiersza w wielu wątkach. Wiersz jest dzielony
+ * na fragmenty, w których równolegle liczone są zmiany głębokości nawiasów;
+ * z ich sum prefiksowych wynika głębokość na początku każdego fragmentu,
+ * więc w każdym fragmencie można niezależnie znaleźć znak '+' na głębokości
+ * zero. Ciągi jednomianów między tymi znakami są wczytywane równolegle,
+ * a ich tablice jednomianów łączone. Wiersz jest poprawnym ciągiem jednomianów
+ * dokładnie wtedy, gdy poprawnymi ciągami jednomianów są wszystkie części
+ * między znakami '+' na głębokości zero, więc wynik i poprawność są takie
+ * same jak przy ParsePoly.
+ * @param[in] curr_line: wiersz
+ * @param[in] line_length: długość wiersza
+ * @param[in] correct: wskaźnik na wartość logiczną, która mówi, czy wielomian jest poprawny.
+ * @return wielomian zbudowany z wczytanego wiersza.
+ */
+static Poly ParsePolyParallel(char *curr_line, size_t line_length, bool *correct) {
+    size_t segments = PARSE_SEGMENTS_PER_THREAD * PoolThreads();
+    ParseSegment *segment = (ParseSegment *) SafeMalloc(segments * sizeof(ParseSegment));
+    TaskGroup group;
+    TaskGroupInit(&group);
+    for (size_t i = 0; i < segments; i++) {
+        segment[i].begin = curr_line + line_length * i / segments;
+        segment[i].end = curr_line + line_length * (i + 1) / segments;
+        PoolSpawn(&group, SegmentDepthRun, &segment[i]);
+    }
+    PoolWait(&group);
+
+    long depth = 0;
+    for (size_t i = 0; i < segments; i++) {
+        long change = segment[i].depth;
+        segment[i].depth = depth;
+        depth += change;
+    }
+    for (size_t i = 0; i < segments; i++)
+        PoolSpawn(&group, SegmentSplitRun, &segment[i]);
+    PoolWait(&group);
+
+    //Każdy ciąg kończymy w miejscu znaku '+', który przywracamy po wczytaniu.
+    ParseChunk *chunk = (ParseChunk *) SafeMalloc((segments + 1) * sizeof(ParseChunk));
+    size_t chunks = 1;
+    chunk[0].text = curr_line;
+    for (size_t i = 0; i < segments; i++) {
+        if (segment[i].split != NULL) {
+            *segment[i].split = '\0';
+            chunk[chunks++].text = segment[i].split + 1;
         }
-
-        *endPtr = *endPtr + 1;
-        if (**endPtr == '+')
-            word = *endPtr + 1;
-        else if (**endPtr == '\n' || **endPtr == '\0' || **endPtr == ',')
-            break;
-        else {
-            *correct = false;
-            free(monos);
-            return PolyZero();
+    }
+    for (size_t i = 0; i < chunks; i++) {
+        chunk[i].end = curr_line + line_length;
+        PoolSpawn(&group, ChunkParseRun, &chunk[i]);
+    }
+    PoolWait(&group);
+    for (size_t i = 0; i < segments; i++) {
+        if (segment[i].split != NULL)
+            *segment[i].split = '+';
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < chunks; i++) {
+        *correct &= chunk[i].correct;
+        total += chunk[i].count;
+    }
+    Poly p = PolyZero();
+    if (*correct) {
+        Mono *monos = (Mono *) SafeMalloc(total * sizeof(Mono));
+        size_t count = 0;
+        for (size_t i = 0; i < chunks; i++) {
+            memcpy(monos + count, chunk[i].monos, chunk[i].count * sizeof(Mono));
+            count += chunk[i].count;
+            free(chunk[i].monos);
         }
-
+        p = PolyOwnMonos(total, monos);
+    } else {
+        for (size_t i = 0; i < chunks; i++)
+            DestroyMonos(chunk[i].monos, chunk[i].count);
     }
-    Poly p = PolyAddMonos(number_of_monos, monos);
-    free(monos);
+    free(chunk);
+    free(segment);
     return p;
 }
 
+/**
+ * Wstawia na stos wielomian zerowy.
+ * @param[in] s: stos
+ * @param[in] line: numer wiersza.
+ */
+static void InstructionZero(Stack *s, size_t line) {
+    (void) line;
+    StackAdd(s, PolyZero());
+}
+
 /**
  * Sprawdza, czy wielomian ze szczytu stosu jest współczynnikiem.
  * W przypadku niepowodzenia wypisuje błąd na wyjście diagnostyczne.
@@ -255,10 +478,26 @@ static void InstructionClone(Stack *s, size_t line) {
         fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", line);
         return;
     }
+    if (StackDeferClone(s))
+        return;
     Poly p = StackTop(s);
+    StackBeginResult(s);
     StackAdd(s, PolyClone(&p));
 }
 
+/**
+ * Zdejmuje ze stosu argumenty operacji, zwalniając je razem z ich arenami,
+ * i wstawia na stos wynik zbudowany od nowa po wywołaniu StackBeginResult.
+ * @param[in] s: stos
+ * @param[in] count: liczba argumentów
+ * @param[in] r: wynik operacji
+ */
+static void ReplaceOperands(Stack *s, size_t count, Poly r) {
+    for (size_t i = 0; i < count; i++)
+        StackDrop(s);
+    StackAdd(s, r);
+}
+
 /**
  * Usuwa dwa wielomiany ze szczytu stosu, dodaje je i wstawia powstały wielomian na stos.
  * W przypadku niepowodzenia wypisuje błąd na wyjście diagnostyczne.
@@ -270,13 +509,19 @@ static void InstructionAdd(Stack *s, size_t line) {
         fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", line);
         return;
     }
-    Poly p = StackTop(s);
-    StackPop(s);
-    Poly q = StackTop(s);
-    StackPop(s);
-    StackAdd(s, PolyAdd(&p, &q));
-    PolyDestroy(&p);
-    PolyDestroy(&q);
+    if (StackDefer(s, LAZY_ADD))
+        return;
+    if (s->use_arenas) {
+        //Bloków areny nie da się zwalniać pojedynczo, więc suma powstaje od nowa, a składniki znikają razem z arenami.
+        Poly p = s->arr[s->size - 1];
+        Poly q = s->arr[s->size - 2];
+        StackBeginResult(s);
+        ReplaceOperands(s, 2, PolyAdd(&p, &q));
+        return;
+    }
+    Poly p = StackTake(s);
+    Poly q = StackTake(s);
+    StackAdd(s, PolyAddOwn(&p, &q));
 }
 
 /**
@@ -290,13 +535,27 @@ static void InstructionMul(Stack *s, size_t line) {
         fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", line);
         return;
     }
-    Poly p = StackTop(s);
-    StackPop(s);
-    Poly q = StackTop(s);
-    StackPop(s);
-    StackAdd(s, PolyMul(&p, &q));
-    PolyDestroy(&p);
-    PolyDestroy(&q);
+    if (StackDefer(s, LAZY_MUL))
+        return;
+    StackForceTop(s, 2);
+    Poly p = s->arr[s->size - 1];
+    Poly q = s->arr[s->size - 2];
+    if (!PolyIsCoeff(&p) && !PolyIsCoeff(&q)) {
+        //Iloczyn powstaje od nowa, więc czynniki zwalniamy razem z ich arenami.
+        StackBeginResult(s);
+        ReplaceOperands(s, 2, PolyMul(&p, &q));
+        return;
+    }
+    //Mnożenie przez współczynnik odbywa się w miejscu drugiego czynnika, więc wynik zostaje w jego arenie.
+    if (PolyIsCoeff(&p)) {
+        StackDrop(s);
+        q = StackTake(s);
+    }
+    else {
+        p = StackTake(s);
+        StackDrop(s);
+    }
+    StackAdd(s, PolyMulOwn(&p, &q));
 }
 
 /**
@@ -310,11 +569,12 @@ static void InstructionNeg(Stack *s, size_t line) {
         fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", line);
         return;
     }
-    Poly p = StackTop(s);
-    Poly temp = PolyFromCoeff(-1);
-    StackPop(s);
-    StackAdd(s, PolyMul(&p, &temp));
-    PolyDestroy(&p);
+    if (StackDefer(s, LAZY_NEG))
+        return;
+    //Negacja odbywa się w miejscu, więc wynik zostaje w arenie argumentu.
+    Poly p = StackTake(s);
+    PolyNegInPlace(&p);
+    StackAdd(s, p);
 }
 
 /**
@@ -328,13 +588,19 @@ static void InstructionSub(Stack *s, size_t line) {
         fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", line);
         return;
     }
-    Poly p = StackTop(s);
-    StackPop(s);
-    Poly q = StackTop(s);
-    StackPop(s);
-    StackAdd(s, PolySub(&p, &q));
-    PolyDestroy(&p);
-    PolyDestroy(&q);
+    if (StackDefer(s, LAZY_SUB))
+        return;
+    if (s->use_arenas) {
+        //Różnica powstaje od nowa z tego samego powodu co suma w InstructionAdd.
+        Poly p = s->arr[s->size - 1];
+        Poly q = s->arr[s->size - 2];
+        StackBeginResult(s);
+        ReplaceOperands(s, 2, PolySub(&p, &q));
+        return;
+    }
+    Poly p = StackTake(s);
+    Poly q = StackTake(s);
+    StackAdd(s, PolySubOwn(&p, &q));
 }
 
 /**
@@ -350,6 +616,7 @@ static void InstructionIsEq(Stack *s, size_t line) {
         fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", line);
         return;
     }
+    StackForceTop(s, 2);
     Poly p = s->arr[s->size - 1];
     Poly q = s->arr[s->size - 2];
     if (PolyIsEq(&p, &q)) {
@@ -399,11 +666,37 @@ static void InstructionPop(Stack *s, size_t line) {
         fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", line);
         return;
     }
-    Poly p = StackTop(s);
-    PolyDestroy(&p);
-    StackPop(s);
+    StackDrop(s);
 }
 
+/**
+ * To jest struktura opisująca polecenie bez argumentów.
+ */
+typedef struct Command {
+    const char *name; ///< nazwa polecenia
+    size_t length; ///< długość nazwy
+    void (*run)(Stack *s, size_t line); ///< funkcja wykonująca polecenie
+} Command;
+
+/** Polecenia bez argumentów. */
+static const Command commands[] = {
+    {"ZERO", 4, InstructionZero},
+    {"IS_COEFF", 8, InstructionIsCoeff},
+    {"IS_ZERO", 7, InstructionIsZero},
+    {"CLONE", 5, InstructionClone},
+    {"ADD", 3, InstructionAdd},
+    {"MUL", 3, InstructionMul},
+    {"NEG", 3, InstructionNeg},
+    {"SUB", 3, InstructionSub},
+    {"IS_EQ", 5, InstructionIsEq},
+    {"DEG", 3, InstructionDeg},
+    {"PRINT", 5, InstructionPrint},
+    {"POP", 3, InstructionPop},
+};
+
+/** Liczba poleceń bez argumentów. */
+#define COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
 /**
  * Wypisuje stopień wielomianu ze szczytu stosu ze względu na podaną zmienną.
  * W przypadku niepowodzenia wypisuje błąd na wyjście diagnostyczne.
@@ -427,11 +720,9 @@ static void InstructionDegBy(Stack *s, size_t line, size_t line_length, char *cu
         fprintf(stderr, "ERROR %zu DEG BY WRONG VARIABLE\n", line);
         return;
     }
-    errno = 0;
-    char *ptr = curr_line + 7;
-    char *endPtr = NULL;
-    unsigned long long var_idx = strtoull(ptr, &endPtr, 10);
-    if (errno == ERANGE) {
+    const char *endPtr = curr_line + 7;
+    unsigned long var_idx;
+    if (!ScanDigits(&endPtr, curr_line + line_length, ULONG_MAX, &var_idx)) {
         fprintf(stderr, "ERROR %zu DEG BY WRONG VARIABLE\n", line);
         return;
     }
@@ -474,11 +765,9 @@ static void InstructionAt(Stack *s, size_t line, size_t line_length, char *curr_
         fprintf(stderr, "ERROR %zu AT WRONG VALUE\n", line);
         return;
     }
-    errno = 0;
-    char *ptr = curr_line + 3;
-    char *endPtr = NULL;
-    long long at = strtoll(ptr, &endPtr, 10);
-    if (errno == ERANGE) {
+    const char *endPtr = curr_line + 3;
+    poly_coeff_t at;
+    if (!ScanCoeff(&endPtr, curr_line + line_length, &at)) {
         fprintf(stderr, "ERROR %zu AT WRONG VALUE\n", line);
         return;
     }
@@ -494,11 +783,15 @@ static void InstructionAt(Stack *s, size_t line, size_t line_length, char *curr_
         fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", line);
         return;
     }
-    Poly p = StackTop(s);
-    Poly q = PolyAt(&p, at);
-    StackPop(s);
-    PolyDestroy(&p);
-    StackAdd(s, q);
+    if (s->use_arenas) {
+        //Wartość powstaje od nowa z tego samego powodu co suma w InstructionAdd.
+        Poly p = StackTop(s);
+        StackBeginResult(s);
+        ReplaceOperands(s, 1, PolyAt(&p, at));
+        return;
+    }
+    Poly p = StackTake(s);
+    StackAdd(s, PolyAtOwn(&p, at));
 }
 
 /**
@@ -526,11 +819,9 @@ static void InstructionCompose(Stack *s, size_t line, size_t line_length, char *
         return;
     }
 
-    errno = 0;
-    char *ptr = curr_line + 8;
-    char *endPtr = NULL;
-    size_t at = strtoull(ptr, &endPtr, 10);
-    if (errno == ERANGE) {
+    const char *endPtr = curr_line + 8;
+    unsigned long at;
+    if (!ScanDigits(&endPtr, curr_line + line_length, ULONG_MAX, &at)) {
         fprintf(stderr, "ERROR %zu COMPOSE WRONG PARAMETER\n", line);
         return;
     }
@@ -542,38 +833,28 @@ static void InstructionCompose(Stack *s, size_t line, size_t line_length, char *
         fprintf(stderr, "ERROR %zu COMPOSE WRONG PARAMETER\n", line);
         return;
     }
-    if (s->size - 1 < at) {
+    if (at >= s->size) {
         fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", line);
         return;
     }
-    Poly* q = (Poly*) SafeMalloc (sizeof(Poly) * at);
+    //Wielomiany q[0], ..., q[k - 1] leżą na stosie kolejno pod wielomianem p.
+    StackForceTop(s, at + 1);
     Poly p = StackTop(s);
-    StackPop(s);
-
-    for (size_t i = 0; i < at; i++) {
-        q[at - 1 - i] = StackTop(s);
-        StackPop(s);
-    }
-
-    Poly r = PolyCompose(&p, at, q);
-    StackAdd(s, r);
+    Poly *q = s->arr + s->size - 1 - at;
 
-    for (size_t i =0;i<at;i++) {
-        PolyDestroy(&q[i]);
-    }
-    free(q);
-    PolyDestroy(&p);
+    StackBeginResult(s);
+    ReplaceOperands(s, at + 1, PolyCompose(&p, at, q));
 }
 
 
 
-void LineInterpreter(char *curr_line, size_t line, size_t line_length, Stack *s) {
+void LineInterpreter(char *curr_line, size_t line, size_t line_length, bool has_nul, Stack *s) {
 
     if (curr_line[0] == '#' || curr_line[0] == '\n')
         return;
 
-    //To słuzy do sprawdzania, czy w poleceniu występuje więcej niż jeden null character.
-    if (strlen(curr_line) != line_length) {
+    //Polecenie nie może zawierać znaku '\0'.
+    if (has_nul) {
         if (isalpha(curr_line[0])) {
             if (strncmp(curr_line, "AT", 2) == 0 && isspace(curr_line[2])) {
                 fprintf(stderr, "ERROR %zu AT WRONG VALUE\n", line);
@@ -597,44 +878,16 @@ void LineInterpreter(char *curr_line, size_t line, size_t line_length, Stack *s)
         }
     }
 
-    if (strcmp(curr_line, "ZERO") == 0 || strcmp(curr_line, "ZERO\n") == 0) {
-        StackAdd(s, PolyZero());
+    //Wiersz bez argumentów musi być dokładnie nazwą polecenia, z końcowym znakiem nowej linii lub bez.
+    size_t command_length = line_length - (curr_line[line_length - 1] == '\n');
+    for (size_t i = 0; i < COMMANDS; i++) {
+        if (commands[i].length == command_length && memcmp(curr_line, commands[i].name, command_length) == 0) {
+            commands[i].run(s, line);
+            return;
+        }
     }
 
-    else if (strcmp(curr_line, "IS_COEFF") == 0 || strcmp(curr_line, "IS_COEFF\n") == 0)
-        InstructionIsCoeff(s, line);
-
-    else if (strcmp(curr_line, "IS_ZERO") == 0 || strcmp(curr_line, "IS_ZERO\n") == 0)
-        InstructionIsZero(s, line);
-
-    else if (strcmp(curr_line, "CLONE") == 0 || strcmp(curr_line, "CLONE\n") == 0)
-        InstructionClone(s, line);
-
-    else if (strcmp(curr_line, "ADD") == 0 || strcmp(curr_line, "ADD\n") == 0)
-        InstructionAdd(s, line);
-
-    else if (strcmp(curr_line, "MUL") == 0 || strcmp(curr_line, "MUL\n") == 0)
-        InstructionMul(s, line);
-
-    else if (strcmp(curr_line, "NEG") == 0 || strcmp(curr_line, "NEG\n") == 0)
-        InstructionNeg(s, line);
-
-    else if (strcmp(curr_line, "SUB") == 0 || strcmp(curr_line, "SUB\n") == 0)
-        InstructionSub(s, line);
-
-    else if (strcmp(curr_line, "IS_EQ") == 0 || strcmp(curr_line, "IS_EQ\n") == 0)
-        InstructionIsEq(s, line);
-
-    else if (strcmp(curr_line, "DEG") == 0 || strcmp(curr_line, "DEG\n") == 0)
-        InstructionDeg(s, line);
-
-    else if (strcmp(curr_line, "PRINT") == 0 || strcmp(curr_line, "PRINT\n") == 0)
-        InstructionPrint(s, line);
-
-    else if (strcmp(curr_line, "POP") == 0 || strcmp(curr_line, "POP\n") == 0)
-        InstructionPop(s, line);
-
-    else if (strncmp(curr_line, "DEG_BY", 6) == 0)
+    if (strncmp(curr_line, "DEG_BY", 6) == 0)
         InstructionDegBy(s, line, line_length, curr_line);
 
     else if (strncmp(curr_line, "AT", 2) == 0)
@@ -649,16 +902,16 @@ void LineInterpreter(char *curr_line, size_t line, size_t line_length, Stack *s)
     }
 
     else {
-        if (!IsCorrect(curr_line)) {
-            fprintf(stderr, "ERROR %zu WRONG POLY\n", line);
-            return;
-        }
-
         bool correct = true;
-        char *endPtr = NULL;
-        Poly p = ParsePoly(curr_line, &correct, &endPtr);
+        StackBeginResult(s);
+        //Długie wielomiany wczytujemy w wielu wątkach, o ile wynik nie powstaje w arenie.
+        bool parallel = line_length >= PARSE_PARALLEL_MIN && curr_line[0] == '(' &&
+                        PoolThreads() > 1 && ArenaCurrent() == NULL;
+        Poly p = parallel ? ParsePolyParallel(curr_line, line_length, &correct) :
+                 ParsePoly(curr_line, curr_line + line_length, &correct);
         if (!correct) {
             PolyDestroy(&p);
+            StackCancelResult(s);
             fprintf(stderr, "ERROR %zu WRONG POLY\n", line);
             return;
         }
@@ -17,8 +17,9 @@
  * @param[in] curr_line: polecenie
  * @param[in] line: numer wiersza
  * @param[in] line_length: długość polecenia
+ * @param[in] has_nul: czy polecenie zawiera znak '\0'
  * @param[in] s: stos
  */
-void LineInterpreter(char* curr_line, size_t line, size_t line_length, Stack* s);
+void LineInterpreter(char* curr_line, size_t line, size_t line_length, bool has_nul, Stack* s);
 
 #endif //PARSER_H
\ No newline at end of file
@@ -7,87 +7,346 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 #include "poly.h"
 #include "memory.h"
+#include "mul.h"
+#include "intern.h"
+#include "leaf.h"
+#include "canon.h"
+#include "pool.h"
 
 /**
- * Podnosi wielomian do zadanej potęgi i go zwraca.
- * @param[in] q : wielomian
- * @param[in] pow : potęga, do jakiej podnoszony będzie wielomian
- * @return wielomian podniesiony do zadanej potęgi
+ * To jest struktura przechowująca obliczoną potęgę wielomianu.
  */
-static Poly PolyPower(const Poly* q, size_t pow) {
+typedef struct CachedPower {
+    poly_exp_t exp; ///< wykładnik
+    Poly power; ///< potęga wielomianu
+} CachedPower;
 
-    if (pow == 1)
-        return PolyClone(q);
-    if (pow == 0)
+/**
+ * To jest struktura przechowująca obliczone potęgi wielomianu podstawianego
+ * za jedną zmienną, posortowane rosnąco względem wykładnika.
+ */
+typedef struct PowerCache {
+    const Poly *base; ///< podstawiany wielomian
+    CachedPower *powers; ///< obliczone potęgi o wykładnikach większych od 1
+    size_t size; ///< liczba obliczonych potęg
+    size_t capacity; ///< pojemność tablicy potęg
+} PowerCache;
+
+/**
+ * To jest struktura przechowująca stan jednego wywołania PolyCompose.
+ */
+typedef struct ComposeState {
+    size_t k; ///< liczba podstawianych wielomianów
+    const Poly *q; ///< podstawiane wielomiany
+    PowerCache *caches; ///< potęgi podstawianych wielomianów, osobno dla każdej zmiennej
+    size_t levels; ///< liczba zmiennych, dla których utworzono już pamięć potęg
+} ComposeState;
+
+/**
+ * Zwraca pamięć potęg wielomianu podstawianego za zmienną @p level.
+ * @param[in,out] state : stan złożenia
+ * @param[in] level : indeks zmiennej, mniejszy od liczby podstawianych wielomianów
+ * @return pamięć potęg
+ */
+static PowerCache *PowerCacheAt(ComposeState *state, size_t level) {
+    if (level >= state->levels) {
+        state->caches = (PowerCache *) SafeRealloc(state->caches, (level + 1) * sizeof(PowerCache));
+        for (size_t i = state->levels; i <= level; i++)
+            state->caches[i] = (PowerCache) {.base = &state->q[i], .powers = NULL, .size = 0, .capacity = 0};
+        state->levels = level + 1;
+    }
+    return &state->caches[level];
+}
+
+/**
+ * Wyznacza liczbę obliczonych potęg o wykładnikach nie większych od zadanego.
+ * @param[in] cache : pamięć potęg
+ * @param[in] exp : wykładnik
+ * @return liczba potęg o wykładnikach nie większych od @p exp
+ */
+static size_t PowerCacheRank(const PowerCache *cache, poly_exp_t exp) {
+    size_t lo = 0, hi = cache->size;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (cache->powers[mid].exp <= exp)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * Zwraca potęgę podstawianego wielomianu, wyliczając ją w razie potrzeby
+ * z najbliższej mniejszej obliczonej potęgi albo przez podnoszenie do kwadratu.
+ * Zwrócony wielomian należy do pamięci potęg i nie wolno go usuwać.
+ * @param[in,out] cache : pamięć potęg
+ * @param[in] exp : wykładnik
+ * @return potęga podstawianego wielomianu
+ */
+static Poly PowerCacheGet(PowerCache *cache, poly_exp_t exp) {
+    if (exp == 0)
         return PolyFromCoeff(1);
-    if (pow % 2 == 0) {
-        Poly temp = PolyPower(q, pow/2);
-        Poly temp2 = PolyMul(&temp, &temp);
-        PolyDestroy(&temp);
-        return temp2;
+    if (exp == 1)
+        return *cache->base;
+
+    size_t rank = PowerCacheRank(cache, exp);
+    if (rank > 0 && cache->powers[rank - 1].exp == exp)
+        return cache->powers[rank - 1].power;
+
+    poly_exp_t lower = rank > 0 ? cache->powers[rank - 1].exp : 1;
+    Poly result;
+    if (exp - lower <= lower) {
+        Poly a = PowerCacheGet(cache, lower);
+        Poly b = PowerCacheGet(cache, exp - lower);
+        result = PolyMul(&a, &b);
+    } else {
+        Poly half = PowerCacheGet(cache, exp / 2);
+        result = PolyMul(&half, &half);
+        if (exp % 2 == 1) {
+            Poly temp = PolyMul(&result, cache->base);
+            PolyDestroy(&result);
+            result = temp;
+        }
     }
-    else {
-        Poly temp = PolyPower(q, (pow-1)/2);
-        Poly temp2 = PolyMul(&temp, &temp);
-        Poly temp3 = PolyMul(q, &temp2);
-        PolyDestroy(&temp);
-        PolyDestroy(&temp2);
-        return temp3;
+
+    //Wywołania rekurencyjne mogły dodać potęgi, więc pozycję wyznaczamy od nowa.
+    if (cache->size == cache->capacity) {
+        cache->capacity = cache->capacity == 0 ? 4 : 2 * cache->capacity;
+        cache->powers = (CachedPower *) SafeRealloc(cache->powers, cache->capacity * sizeof(CachedPower));
     }
+    rank = PowerCacheRank(cache, exp);
+    memmove(cache->powers + rank + 1, cache->powers + rank, (cache->size - rank) * sizeof(CachedPower));
+    cache->powers[rank] = (CachedPower) {.exp = exp, .power = result};
+    cache->size++;
+    return result;
 }
 
+static Poly ComposeAt(ComposeState *state, const Poly *p, size_t level);
 
+/**
+ * Składa z wielomianami podstawianymi za zmienne od @p level wzwyż sumę
+ * jednomianów wielomianu o indeksach od @p lo do @p hi - 1.
+ * Jednomiany są przetwarzane schematem Hornera od największego wykładnika,
+ * a mnożniki to potęgi o wykładnikach równych różnicom kolejnych wykładników.
+ * @param[in,out] state : stan złożenia
+ * @param[in] p : wielomian, który nie jest współczynnikiem
+ * @param[in] level : indeks zmiennej głównej wielomianu @p p, mniejszy od liczby podstawianych wielomianów
+ * @param[in] lo : indeks pierwszego jednomianu
+ * @param[in] hi : indeks za ostatnim jednomianem, większy od @p lo
+ * @return wynik złożenia sumy jednomianów
+ */
+static Poly ComposeRange(ComposeState *state, const Poly *p, size_t level, size_t lo, size_t hi) {
+    //Rekurencja może przenieść tablicę pamięci potęg, więc nie trzymamy wskaźnika na nią.
+    Poly acc = ComposeAt(state, &p->arr[hi - 1].p, level + 1);
+    for (size_t i = hi - 1; i > lo; i--) {
+        Poly power = PowerCacheGet(PowerCacheAt(state, level), p->arr[i].exp - p->arr[i - 1].exp);
+        Poly product = PolyMul(&acc, &power);
+        PolyDestroy(&acc);
+        Poly coeff = ComposeAt(state, &p->arr[i - 1].p, level + 1);
+        acc = PolyAddOwn(&product, &coeff);
+    }
+    if (p->arr[lo].exp > 0) {
+        Poly power = PowerCacheGet(PowerCacheAt(state, level), p->arr[lo].exp);
+        Poly product = PolyMul(&acc, &power);
+        PolyDestroy(&acc);
+        acc = product;
+    }
+    return acc;
+}
 
 /**
- * Składa wielomian dany z wielomianami danymi w tablicy i zwraca wynik operacji złożenia.
+ * Składa wielomian z wielomianami podstawianymi za zmienne od @p level wzwyż.
+ * @param[in,out] state : stan złożenia
  * @param[in] p : wielomian
- * @param[in] k : liczba wielomianów w tablicy
- * @param[in] q : tablica wielomianów
- * @return wynik operacji złożenia
+ * @param[in] level : indeks zmiennej głównej wielomianu @p p
+ * @return wynik złożenia
  */
-Poly PolyCompose(const Poly *p, size_t k, const Poly q[]) {
-
-    if (PolyIsCoeff(p)) {
+static Poly ComposeAt(ComposeState *state, const Poly *p, size_t level) {
+    if (PolyIsCoeff(p))
         return PolyClone(p);
+
+    //Za zmienne, dla których zabrakło wielomianów, podstawiamy zero.
+    if (level >= state->k) {
+        if (p->arr[0].exp != 0)
+            return PolyZero();
+        return ComposeAt(state, &p->arr[0].p, level + 1);
     }
-    Poly _q;
-    size_t _k;
-    if (k == 0) {
-        _q = PolyZero();
-        _k = 0;
-    }
-    else {
-        _q = *q;
-        _k = k - 1;
+
+    return ComposeRange(state, p, level, 0, p->size);
+}
+
+/**
+ * Zwalnia pamięć potęg stanu złożenia dla zmiennych od @p from wzwyż.
+ * @param[in,out] state : stan złożenia
+ * @param[in] from : indeks pierwszej zwalnianej zmiennej
+ */
+static void ComposeStateDestroy(ComposeState *state, size_t from) {
+    for (size_t i = from; i < state->levels; i++) {
+        for (size_t j = 0; j < state->caches[i].size; j++)
+            PolyDestroy(&state->caches[i].powers[j].power);
+        free(state->caches[i].powers);
     }
+    free(state->caches);
+}
 
+/** Liczba bloków jednomianów przypadających na jeden wątek przy równoległym złożeniu. */
+#define COMPOSE_BLOCKS_PER_THREAD 4
 
-    Poly res = PolyZero();
-    for (size_t i = 0; i < p->size; i++) {
-        Poly temp = PolyPower(&_q, p->arr[i].exp);
-        Poly temp2 = PolyCompose(&p->arr[i].p, _k, q+1);
-        Poly temp3 = PolyMul(&temp, &temp2);
-        Poly temp4 = res;
-        res = PolyAdd(&temp3,&temp4);
-		PolyDestroy(&temp2);
-        PolyDestroy(&temp3);
-        PolyDestroy(&temp);
-        PolyDestroy(&temp4);
+/** Liczba jednomianów, od której złożenie jest dzielone między wątki. */
+#define COMPOSE_PARALLEL_MIN 8
+
+/**
+ * To jest struktura opisująca zadanie równoległego złożenia: blok kolejnych
+ * jednomianów wielomianu albo parę wyników do dodania.
+ */
+typedef struct ComposeTask {
+    const ComposeState *shared; ///< stan złożenia z wyliczonymi potęgami dla zmiennej 0
+    const Poly *p; ///< składany wielomian
+    size_t lo; ///< indeks pierwszego jednomianu bloku
+    size_t hi; ///< indeks za ostatnim jednomianem bloku
+    Poly *result; ///< wynik złożenia bloku, a przy dodawaniu pierwszy z dwóch składników
+} ComposeTask;
+
+/**
+ * Składa blok jednomianów. Potęgi dla zmiennej 0 są już wyliczone, więc są
+ * tylko odczytywane ze wspólnego stanu, a potęgi dla dalszych zmiennych
+ * zadanie wylicza we własnym stanie.
+ * @param[in,out] arg : zadanie
+ */
+static void ComposeBlockRun(void *arg) {
+    ComposeTask *task = (ComposeTask *) arg;
+    ComposeState state = {.k = task->shared->k, .q = task->shared->q, .caches = NULL, .levels = 0};
+    *PowerCacheAt(&state, 0) = task->shared->caches[0];
+    *task->result = ComposeRange(&state, task->p, 0, task->lo, task->hi);
+    ComposeStateDestroy(&state, 1);
+}
+
+/**
+ * To jest struktura opisująca zadanie wyliczenia potęg dla zmiennej 0
+ * przed równoległym złożeniem.
+ */
+typedef struct ComposePowers {
+    ComposeState *state; ///< stan złożenia
+    const Poly *p; ///< składany wielomian
+    size_t blocks; ///< liczba bloków jednomianów
+} ComposePowers;
+
+/**
+ * Wylicza potęgi podstawianego wielomianu dla zmiennej 0 potrzebne przy
+ * składaniu bloków: dla różnic kolejnych wykładników i dla wykładników
+ * pierwszych jednomianów bloków. Jest zadaniem puli wątków, więc mnożenia
+ * potęg nie są dzielone między wątki.
+ * @param[in,out] arg : zadanie
+ */
+static void ComposePowersRun(void *arg) {
+    ComposePowers *task = (ComposePowers *) arg;
+    const Poly *p = task->p;
+    PowerCache *cache = PowerCacheAt(task->state, 0);
+    for (size_t i = 1; i < p->size; i++)
+        PowerCacheGet(cache, p->arr[i].exp - p->arr[i - 1].exp);
+    for (size_t i = 0; i < task->blocks; i++)
+        PowerCacheGet(cache, p->arr[p->size * i / task->blocks].exp);
+}
+
+/**
+ * Dodaje wynik następujący w tablicy po wskazanym do wskazanego wyniku.
+ * @param[in,out] arg : zadanie
+ */
+static void ComposeSumRun(void *arg) {
+    ComposeTask *task = (ComposeTask *) arg;
+    *task->result = PolyAddOwn(&task->result[0], &task->result[1]);
+}
+
+/**
+ * Składa wielomian w wielu wątkach. Jednomiany są dzielone na bloki składane
+ * niezależnie schematem Hornera, a wyniki bloków są dodawane parami, drzewem
+ * o logarytmicznej wysokości, także równolegle.
+ * @param[in,out] state : stan złożenia bez wyliczonych potęg
+ * @param[in] p : wielomian, który nie jest współczynnikiem
+ * @return wynik złożenia
+ */
+static Poly ComposeParallel(ComposeState *state, const Poly *p) {
+    size_t blocks = COMPOSE_BLOCKS_PER_THREAD * PoolThreads();
+    if (blocks > p->size)
+        blocks = p->size;
+
+    ComposeTask *tasks = (ComposeTask *) SafeMalloc(blocks * sizeof(ComposeTask));
+    Poly *results = (Poly *) SafeMalloc(blocks * sizeof(Poly));
+    TaskGroup group;
+    TaskGroupInit(&group);
+
+    //Wszystkie potrzebne potęgi dla zmiennej 0 wyliczamy z góry, żeby zadania ich nie zmieniały.
+    //Robimy to w zadaniu puli, bo poza nim każde mnożenie potęg byłoby dzielone na bloki.
+    ComposePowers powers = {.state = state, .p = p, .blocks = blocks};
+    PoolSpawn(&group, ComposePowersRun, &powers);
+    PoolWait(&group);
+
+    for (size_t i = 0; i < blocks; i++) {
+        tasks[i] = (ComposeTask) {.shared = state, .p = p, .lo = p->size * i / blocks,
+                                  .hi = p->size * (i + 1) / blocks, .result = &results[i]};
+        PoolSpawn(&group, ComposeBlockRun, &tasks[i]);
+    }
+    PoolWait(&group);
+
+    for (size_t count = blocks; count > 1; count = (count + 1) / 2) {
+        for (size_t i = 0; i + 1 < count; i += 2) {
+            tasks[i / 2] = (ComposeTask) {.result = &results[i]};
+            PoolSpawn(&group, ComposeSumRun, &tasks[i / 2]);
+        }
+        PoolWait(&group);
+        for (size_t i = 0; i < count; i += 2)
+            results[i / 2] = results[i];
     }
 
-    return res;
+    Poly result = results[0];
+    free(results);
+    free(tasks);
+    return result;
+}
+
+/**
+ * Sprawdza, czy złożenie warto podzielić między wątki. Tak jak przy mnożeniu
+ * nie dzielimy go wewnątrz zadań puli ani przy ustawionej arenie.
+ * @param[in] p : wielomian
+ * @param[in] k : liczba podstawianych wielomianów
+ * @return czy składać równolegle
+ */
+static bool ComposeShouldSplit(const Poly *p, size_t k) {
+    return k > 0 && !PolyIsCoeff(p) && p->size >= COMPOSE_PARALLEL_MIN &&
+           PoolThreads() > 1 && !PoolInTask() && ArenaCurrent() == NULL;
+}
 
+/**
+ * Składa wielomian dany z wielomianami danymi w tablicy i zwraca wynik operacji złożenia.
+ * Potęgi podstawianych wielomianów są wyliczane raz na całe wywołanie.
+ * Przy więcej niż jednym wątku puli (zob. PoolSetThreads) duże wielomiany
+ * są składane równolegle.
+ * @param[in] p : wielomian
+ * @param[in] k : liczba wielomianów w tablicy
+ * @param[in] q : tablica wielomianów
+ * @return wynik operacji złożenia
+ */
+Poly PolyCompose(const Poly *p, size_t k, const Poly q[]) {
+    ComposeState state = {.k = k, .q = q, .caches = NULL, .levels = 0};
+    Poly result = ComposeShouldSplit(p, k) ? ComposeParallel(&state, p) : ComposeAt(&state, p, 0);
+    ComposeStateDestroy(&state, 0);
+    return result;
 }
 
 void PolyDestroy(Poly *p) {
     assert(p != NULL);
     if (p->arr == NULL) return;
+    //Współdzieloną tablicę zwalnia dopiero ostatni jej właściciel.
+    if (!BlockRelease(p->arr)) return;
+    if (BlockIsInterned(p->arr)) PolyInternForget(p);
     for (size_t i = 0; i < p->size; i++) {
         PolyDestroy(&p->arr[i].p);
     }
-    free(p->arr);
+    BlockFree(p->arr);
 }
 
 Poly PolyClone(const Poly *p) {
@@ -95,13 +354,43 @@ Poly PolyClone(const Poly *p) {
     if (PolyIsCoeff(p)) {
         return (Poly) {.coeff = p->coeff, .arr = NULL};
     }
-    Mono *arr = (Mono *) SafeMalloc((p->size) * sizeof(Mono));
+    if (BlockShare(p->arr))
+        return *p;
+    //Tablicę przepisujemy naraz, a w głąb kopiujemy tylko współczynniki,
+    //które nie są liczbami, więc poziom liściowy to jedno przepisanie pamięci.
+    Mono *arr = (Mono *) BlockAlloc((p->size) * sizeof(Mono));
+    memcpy(arr, p->arr, p->size * sizeof(Mono));
     for (size_t i = 0; i < p->size; i++) {
-        arr[i] = MonoClone(&p->arr[i]);
+        if (!PolyIsCoeff(&arr[i].p))
+            arr[i].p = PolyClone(&p->arr[i].p);
     }
     return (Poly) {.size = p->size, .arr = arr};
 }
 
+/**
+ * Zapewnia, że tablica jednomianów wielomianu nie jest współdzielona ani
+ * umieszczona w tablicy postaci kanonicznych i może być zmieniana w miejscu.
+ * Taką tablicę kopiuje na jednym poziomie: współczynniki kopii nadal
+ * współdzielą swoje tablice z oryginałem.
+ * @param[in,out] p : wielomian @f$p@f$
+ */
+static void PolyUnshare(Poly *p) {
+    if (PolyIsCoeff(p) || (!BlockIsShared(p->arr) && !BlockIsInterned(p->arr)))
+        return;
+    Poly old = *p;
+    p->arr = (Mono *) BlockAlloc(p->size * sizeof(Mono));
+    for (size_t i = 0; i < p->size; i++)
+        p->arr[i] = MonoClone(&old.arr[i]);
+    PolyDestroy(&old);
+}
+
+Poly PolyCloneIn(Arena *arena, const Poly *p) {
+    Arena *previous = ArenaUse(arena);
+    Poly result = PolyClone(p);
+    ArenaUse(previous);
+    return result;
+}
+
 /**
  * Dodaje skalar do wielomianu.
  * @param[in] q : wielomian @f$q@f$
@@ -110,20 +399,20 @@ Poly PolyClone(const Poly *p) {
  */
 static Poly PolyAddCoeff(const Poly *q, poly_coeff_t scalar) {
     assert(q != NULL);
-    if (PolyIsCoeff(q)) return PolyFromCoeff(scalar + q->coeff);
+    if (PolyIsCoeff(q)) return PolyFromCoeff((poly_coeff_t) ((unsigned long) scalar + (unsigned long) q->coeff));
     //Tutaj dwa przypadki w zależności od tego, czy w wielomianie jest już jakiś niezerowy skalar.
     //Korzystamy z tego, że stworzone wielomiany mają posortowane jednomiany względem wykładnika.
     if (q->arr[0].exp == 0) {
         Poly coeff = PolyAddCoeff(&q->arr[0].p, scalar);
         if (PolyIsZero(&coeff)) {
-            Mono *_arr = (Mono *) SafeMalloc((q->size - 1) * sizeof(Mono));
+            Mono *_arr = (Mono *) BlockAlloc((q->size - 1) * sizeof(Mono));
             for (size_t i = 0; i < q->size - 1; i++) {
                 _arr[i] = MonoClone(&q->arr[i + 1]);
             }
             return (Poly) {.size = q->size - 1, .arr = _arr};
         }
 
-        Mono *_arr = (Mono *) SafeMalloc((q->size) * sizeof(Mono));
+        Mono *_arr = (Mono *) BlockAlloc((q->size) * sizeof(Mono));
         for (size_t i = 1; i < q->size; i++) {
             _arr[i] = MonoClone(&q->arr[i]);
         }
@@ -133,7 +422,7 @@ static Poly PolyAddCoeff(const Poly *q, poly_coeff_t scalar) {
         return (Poly) {.size = q->size, .arr = _arr};
     }
 
-    Mono *_arr = (Mono *) SafeMalloc((q->size + 1) * sizeof(Mono));
+    Mono *_arr = (Mono *) BlockAlloc((q->size + 1) * sizeof(Mono));
     _arr[0].p = PolyFromCoeff(scalar);
     _arr[0].exp = 0;
 
@@ -154,7 +443,7 @@ Poly PolyAdd(const Poly *p, const Poly *q) {
         return PolyClone(p);
 
     if (PolyIsCoeff(p) && PolyIsCoeff(q))
-        return PolyFromCoeff(p->coeff + q->coeff);
+        return PolyFromCoeff((poly_coeff_t) ((unsigned long) p->coeff + (unsigned long) q->coeff));
 
     if (PolyIsCoeff(p))
         return PolyAddCoeff(q, p->coeff);
@@ -162,74 +451,94 @@ Poly PolyAdd(const Poly *p, const Poly *q) {
     if (PolyIsCoeff(q))
         return PolyAddCoeff(p, q->coeff);
 
-    size_t size = 0;
+    return LeafAdd(p, q);
+}
 
-    Mono *arr = (Mono *) SafeMalloc((p->size + q->size) * sizeof(Mono));
-    size_t i = 0, j = 0;
-    Poly temp;
-    //Korzystamy z tego, że jednomiany są posortowane względem wykładnika i przesuwamy odpowiednie indeksy.
+Poly PolyFinish(Mono *arr, size_t size) {
+    if (size == 0) {
+        BlockFree(arr);
+        return PolyZero();
+    }
+    if (size == 1 && arr[0].exp == 0 && PolyIsCoeff(&arr[0].p)) {
+        poly_coeff_t c = arr[0].p.coeff;
+        BlockFree(arr);
+        return PolyFromCoeff(c);
+    }
+    return (Poly) {.size = size, .arr = arr};
+}
+
+/**
+ * Dodaje skalar do wielomianu, przejmując go na własność.
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] scalar : niezerowy skalar @f$scalar@f$
+ * @return @f$q + scalar@f$
+ */
+static Poly PolyAddCoeffOwn(Poly *q, poly_coeff_t scalar) {
+    if (PolyIsCoeff(q)) return PolyFromCoeff((poly_coeff_t) ((unsigned long) scalar + (unsigned long) q->coeff));
+    PolyUnshare(q);
+    if (q->arr[0].exp == 0) {
+        q->arr[0].p = PolyAddCoeffOwn(&q->arr[0].p, scalar);
+        if (PolyIsZero(&q->arr[0].p)) {
+            memmove(q->arr, q->arr + 1, (q->size - 1) * sizeof(Mono));
+            *q = PolyFinish(q->arr, q->size - 1);
+        }
+        return *q;
+    }
+
+    q->arr = (Mono *) BlockRealloc(q->arr, (q->size + 1) * sizeof(Mono));
+    memmove(q->arr + 1, q->arr, q->size * sizeof(Mono));
+    q->arr[0].p = PolyFromCoeff(scalar);
+    q->arr[0].exp = 0;
+    q->size++;
+    return *q;
+}
+
+Poly PolyAddOwn(Poly *p, Poly *q) {
+    assert(p != NULL && q != NULL);
+
+    if (PolyIsZero(p))
+        return *q;
+
+    if (PolyIsZero(q))
+        return *p;
+
+    if (PolyIsCoeff(p) && PolyIsCoeff(q))
+        return PolyFromCoeff((poly_coeff_t) ((unsigned long) p->coeff + (unsigned long) q->coeff));
+
+    if (PolyIsCoeff(p))
+        return PolyAddCoeffOwn(q, p->coeff);
+
+    if (PolyIsCoeff(q))
+        return PolyAddCoeffOwn(p, q->coeff);
+
+    //Jednomiany są przenoszone do nowej tablicy bez kopiowania ich współczynników.
+    PolyUnshare(p);
+    PolyUnshare(q);
+    Poly result = {.size = 0, .arr = (Mono *) BlockAlloc((p->size + q->size) * sizeof(Mono))};
+    size_t size = 0, i = 0, j = 0;
     while (i < p->size && j < q->size) {
         if (p->arr[i].exp < q->arr[j].exp) {
-            arr[size] = MonoClone(&p->arr[i]);
-            size++;
-            i++;
+            result.arr[size++] = p->arr[i++];
         } else if (p->arr[i].exp > q->arr[j].exp) {
-            arr[size] = MonoClone(&q->arr[j]);
-            size++;
-            j++;
+            result.arr[size++] = q->arr[j++];
         } else {
-            temp = PolyAdd(&p->arr[i].p, &q->arr[j].p);
-            if (PolyIsZero(&temp)) {
-                i++;
-                j++;
-            } else {
-                bool added = false;
-                if (temp.arr != NULL) {
-                    if (temp.size == 1 && PolyIsZero(&temp.arr[0].p)) {
-                        PolyDestroy(&temp);
-                        added = true;
-                    }
-                }
-
-                if (!added) {
-                    arr[size].exp = p->arr[i].exp;
-                    arr[size].p = temp;
-                    size++;
-                }
-
-                i++;
-                j++;
+            Poly sum = PolyAddOwn(&p->arr[i].p, &q->arr[j].p);
+            if (!PolyIsZero(&sum)) {
+                result.arr[size].exp = p->arr[i].exp;
+                result.arr[size++].p = sum;
             }
-        }
-    }
-    size_t ii = i;
-    size_t jj = j;
-
-    if (ii == p->size) {
-        while (j < q->size) {
-            arr[size] = MonoClone(&q->arr[j]);
-            size++;
-            j++;
-        }
-    } else if (jj == q->size) {
-        while (i < p->size) {
-            arr[size] = MonoClone(&p->arr[i]);
-            size++;
             i++;
+            j++;
         }
     }
-
-    if (size == 0) {
-        free(arr);
-        return PolyZero();
-    }
-    //Jeśli powstały wielomian jest współczynnikiem, ale wygenerowało się tak, że ma jeden jednomian
-    //który jest wspóczynnikiem, to zamieniamy to na wielomian o pustej tablicy i danym wspóczynniku.
-    if (size == 1 && PolyIsCoeff(&arr[0].p) && arr[0].exp == 0) {
-        poly_coeff_t c = arr[0].p.coeff;
-        free(arr);
-        return PolyFromCoeff(c);
-    } else return (Poly) {.size = size, .arr = arr};
+    while (i < p->size)
+        result.arr[size++] = p->arr[i++];
+    while (j < q->size)
+        result.arr[size++] = q->arr[j++];
+
+    BlockFree(p->arr);
+    BlockFree(q->arr);
+    return PolyFinish(result.arr, size);
 }
 
 bool PolyIsEq(const Poly *p, const Poly *q) {
@@ -242,12 +551,25 @@ bool PolyIsEq(const Poly *p, const Poly *q) {
     if (p->arr == NULL || q->arr == NULL)
         return false;
 
+    //Wspólna tablica jednomianów to ten sam wielomian, a różne tablice
+    //z tablicy postaci kanonicznych to na pewno różne wielomiany.
+    if (p->arr == q->arr)
+        return true;
+
+    if (BlockIsInterned(p->arr) && BlockIsInterned(q->arr))
+        return false;
+
     if (p->size != q->size)
         return false;
 
     for (size_t i = 0; i < p->size; i++) {
         if (p->arr[i].exp != q->arr[i].exp) return false;
-        if (!PolyIsEq(&p->arr[i].p, &q->arr[i].p)) return false;
+        //Na poziomach liściowych porównujemy liczby bez wywołań rekurencyjnych.
+        if (p->arr[i].p.arr == NULL && q->arr[i].p.arr == NULL) {
+            if (p->arr[i].p.coeff != q->arr[i].p.coeff) return false;
+        } else if (!PolyIsEq(&p->arr[i].p, &q->arr[i].p)) {
+            return false;
+        }
     }
 
     return true;
@@ -255,65 +577,266 @@ bool PolyIsEq(const Poly *p, const Poly *q) {
 }
 
 /**
- * Komparator dla jednomianów ze względu na wykładnik.
- * @param[in] a : jednomian @f$p@f$
- * @param[in] b : jednomian @f$q@f$
- * @return liczba dodatnia jeśli wykładnik w pierwszym jednomianie większy, zero jeśli równe, liczba ujemna w przeciwnym przypadku
+ * To jest struktura opisująca składnik sumowany przez PolySumManyOwn:
+ * jego tablicę jednomianów i pierwszy jeszcze nieprzetworzony jednomian.
  */
-static int MonoCmp(const void *a, const void *b) {
-    return ((Mono *) a)->exp - ((Mono *) b)->exp;
+typedef struct SumSource {
+    Mono *arr; ///< tablica jednomianów składnika
+    size_t size; ///< liczba jednomianów
+    size_t next; ///< indeks pierwszego nieprzetworzonego jednomianu
+} SumSource;
+
+/**
+ * Przywraca własność kopca minimalnego składników, uporządkowanego
+ * względem wykładników ich pierwszych nieprzetworzonych jednomianów,
+ * przesuwając element w dół.
+ * @param[in] sources : składniki
+ * @param[in,out] heap : kopiec indeksów składników
+ * @param[in] size : rozmiar kopca
+ * @param[in] k : indeks przesuwanego elementu
+ */
+static void SumHeapDown(const SumSource *sources, size_t *heap, size_t size, size_t k) {
+    size_t moved = heap[k];
+    poly_exp_t exp = sources[moved].arr[sources[moved].next].exp;
+    while (true) {
+        size_t child = 2 * k + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size &&
+            sources[heap[child + 1]].arr[sources[heap[child + 1]].next].exp <
+            sources[heap[child]].arr[sources[heap[child]].next].exp)
+            child++;
+        if (exp <= sources[heap[child]].arr[sources[heap[child]].next].exp)
+            break;
+        heap[k] = heap[child];
+        k = child;
+    }
+    heap[k] = moved;
 }
 
-Poly PolyAddMonos(size_t count, const Mono monos[]) {
-    if (count == 0)
+Poly PolySumManyOwn(size_t n, Poly ps[]) {
+    assert(n == 0 || ps != NULL);
+    //Dla jednego i dwóch składników scalanie przez kopiec niczego nie oszczędza.
+    if (n == 0)
         return PolyZero();
+    if (n == 1)
+        return ps[0];
+    if (n == 2)
+        return PolyAddOwn(&ps[0], &ps[1]);
+
+    unsigned long constant = 0;
+    size_t count = 0, total = 0;
+    SumSource *sources = (SumSource *) SafeMalloc((n + 1) * sizeof(SumSource));
+    for (size_t i = 0; i < n; i++) {
+        if (PolyIsCoeff(&ps[i])) {
+            constant += (unsigned long) ps[i].coeff;
+            continue;
+        }
+        //Jednomiany składników są przenoszone do wyniku, więc tablice nie mogą być współdzielone.
+        PolyUnshare(&ps[i]);
+        sources[count++] = (SumSource) {.arr = ps[i].arr, .size = ps[i].size, .next = 0};
+        total += ps[i].size;
+    }
+    if (count == 0) {
+        free(sources);
+        return PolyFromCoeff((poly_coeff_t) constant);
+    }
+    if (count == 1 && constant == 0) {
+        Poly result = {.size = sources[0].size, .arr = sources[0].arr};
+        free(sources);
+        return result;
+    }
 
-    Mono *arr = (Mono *) SafeMalloc(count * sizeof(Mono));
-    for (size_t i = 0; i < count; i++) {
-        arr[i] = monos[i];
+    size_t *heap = (size_t *) SafeMalloc(count * sizeof(size_t));
+    size_t heap_size = count;
+    for (size_t k = 0; k < count; k++)
+        heap[k] = k;
+    for (size_t k = count / 2; k > 0; k--)
+        SumHeapDown(sources, heap, heap_size, k - 1);
+
+    Mono *arr = (Mono *) BlockAlloc((total + 1) * sizeof(Mono));
+    Poly *group = (Poly *) SafeMalloc((count + 1) * sizeof(Poly));
+    size_t size = 0;
+    //Stała jest jednomianem o wykładniku zero, scalanym razem z pozostałymi.
+    if (constant != 0 && sources[heap[0]].arr[sources[heap[0]].next].exp > 0) {
+        arr[size].p = PolyFromCoeff((poly_coeff_t) constant);
+        arr[size++].exp = 0;
+        constant = 0;
+    }
+    while (heap_size > 0) {
+        poly_exp_t exp = sources[heap[0]].arr[sources[heap[0]].next].exp;
+        size_t members = 0;
+        if (constant != 0) {
+            group[members++] = PolyFromCoeff((poly_coeff_t) constant);
+            constant = 0;
+        }
+        //Zbieramy współczynniki jednomianów o tym wykładniku ze wszystkich składników.
+        while (heap_size > 0 && sources[heap[0]].arr[sources[heap[0]].next].exp == exp) {
+            SumSource *source = &sources[heap[0]];
+            group[members++] = source->arr[source->next++].p;
+            if (source->next == source->size)
+                heap[0] = heap[--heap_size];
+            if (heap_size > 0)
+                SumHeapDown(sources, heap, heap_size, 0);
+        }
+        Poly sum = members == 1 ? group[0] : PolySumManyOwn(members, group);
+        if (!PolyIsZero(&sum)) {
+            arr[size].p = sum;
+            arr[size++].exp = exp;
+        }
     }
 
-    //Zwracany wielomian będzie posortowany względem wykładników jednomianów.
-    qsort(arr, count, sizeof(Mono), MonoCmp);
-
-    for (size_t i = 0; i < count - 1; i++) {
-        if (arr[i].exp == arr[i + 1].exp) {
-            Poly temp = arr[i + 1].p;
-            arr[i + 1].p = PolyAdd(&arr[i + 1].p, &arr[i].p);
-            PolyDestroy(&temp);
-            PolyDestroy(&arr[i].p);
-            arr[i].p = PolyZero();
+    for (size_t k = 0; k < count; k++)
+        BlockFree(sources[k].arr);
+    free(group);
+    free(heap);
+    free(sources);
+    return PolyFinish(arr, size);
+}
+
+Poly PolySumMany(size_t n, const Poly ps[]) {
+    assert(n == 0 || ps != NULL);
+    //Kopie współdzielą tablice z oryginałami, więc kopiowane są tylko scalane poziomy.
+    Poly *copies = (Poly *) SafeMalloc((n + 1) * sizeof(Poly));
+    for (size_t i = 0; i < n; i++)
+        copies[i] = PolyClone(&ps[i]);
+    Poly result = PolySumManyOwn(n, copies);
+    free(copies);
+    return result;
+}
+
+/** Liczba jednomianów, od której nieposortowana tablica jest sortowana pozycyjnie. */
+#define MONO_RADIX_MIN 64
+
+/** Liczba bitów wykładnika przetwarzanych w jednej fazie sortowania pozycyjnego. */
+#define MONO_RADIX_BITS 11
+
+/** Liczba faz sortowania pozycyjnego, pokrywająca 31 bitów nieujemnego wykładnika. */
+#define MONO_RADIX_PASSES 3
+
+/**
+ * Sortuje stabilnie krótką tablicę jednomianów względem wykładników przez wstawianie.
+ * @param[in,out] arr : tablica jednomianów
+ * @param[in] count : liczba jednomianów
+ */
+static void MonosInsertionSort(Mono *arr, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        Mono mono = arr[i];
+        size_t j = i;
+        while (j > 0 && arr[j - 1].exp > mono.exp) {
+            arr[j] = arr[j - 1];
+            j--;
         }
+        arr[j] = mono;
     }
-    size_t counter = 0;
+}
 
+/**
+ * Sortuje stabilnie tablicę jednomianów względem nieujemnych wykładników
+ * sortowaniem pozycyjnym od najmniej znaczących cyfr. Histogramy wszystkich
+ * faz są liczone w jednym przejściu, a fazy, w których wszystkie wykładniki
+ * mają tę samą cyfrę, są pomijane, więc małe wykładniki wymagają jednej fazy.
+ * @param[in,out] arr : tablica jednomianów
+ * @param[in] count : liczba jednomianów
+ */
+static void MonosRadixSort(Mono *arr, size_t count) {
+    const size_t buckets = (size_t) 1 << MONO_RADIX_BITS;
+    const unsigned mask = (unsigned) buckets - 1;
+    size_t *histogram = (size_t *) SafeCalloc(MONO_RADIX_PASSES * buckets, sizeof(size_t));
     for (size_t i = 0; i < count; i++) {
-        if (!PolyIsZero(&arr[i].p))
-            counter++;
+        unsigned exp = (unsigned) arr[i].exp;
+        for (size_t pass = 0; pass < MONO_RADIX_PASSES; pass++)
+            histogram[pass * buckets + ((exp >> (pass * MONO_RADIX_BITS)) & mask)]++;
     }
 
-    if (counter == 0) {
-        free(arr);
-        return PolyZero();
+    Mono *buffer = (Mono *) SafeMalloc(count * sizeof(Mono));
+    Mono *from = arr, *to = buffer;
+    for (size_t pass = 0; pass < MONO_RADIX_PASSES; pass++) {
+        size_t *offsets = histogram + pass * buckets;
+        unsigned shift = (unsigned) (pass * MONO_RADIX_BITS);
+        if (offsets[((unsigned) from[0].exp >> shift) & mask] == count)
+            continue;
+
+        size_t sum = 0;
+        for (size_t d = 0; d < buckets; d++) {
+            size_t bucket = offsets[d];
+            offsets[d] = sum;
+            sum += bucket;
+        }
+        for (size_t i = 0; i < count; i++)
+            to[offsets[((unsigned) from[i].exp >> shift) & mask]++] = from[i];
+        Mono *temp = from;
+        from = to;
+        to = temp;
     }
+    if (from != arr)
+        memcpy(arr, from, count * sizeof(Mono));
+    free(buffer);
+    free(histogram);
+}
 
-    size_t j = 0;
-    for (size_t i = 0; i < count; i++) {
-        if (!PolyIsZero(&arr[i].p)) {
-            arr[j] = arr[i];
-            j++;
+/**
+ * Sortuje tablicę jednomianów względem wykładników. Tablice już posortowane
+ * rosnąco lub malejąco, jakie zwykle tworzą parser i mnożenie, są
+ * rozpoznawane w czasie liniowym.
+ * @param[in,out] arr : tablica jednomianów o nieujemnych wykładnikach
+ * @param[in] count : liczba jednomianów
+ */
+static void MonosSort(Mono *arr, size_t count) {
+    bool ascending = true, descending = true;
+    for (size_t i = 1; i < count && (ascending || descending); i++) {
+        ascending &= arr[i - 1].exp <= arr[i].exp;
+        descending &= arr[i - 1].exp >= arr[i].exp;
+    }
+    if (ascending)
+        return;
+    if (descending) {
+        //Kolejność jednomianów o równych wykładnikach nie ma znaczenia,
+        //bo i tak zostaną zsumowane.
+        for (size_t i = 0, j = count - 1; i < j; i++, j--) {
+            Mono temp = arr[i];
+            arr[i] = arr[j];
+            arr[j] = temp;
         }
+        return;
     }
+    if (count < MONO_RADIX_MIN)
+        MonosInsertionSort(arr, count);
+    else
+        MonosRadixSort(arr, count);
+}
+
+Poly PolyAddMonos(size_t count, const Mono monos[]) {
+    if (count == 0)
+        return PolyZero();
 
-    if (counter == 1 && arr[0].exp == 0 && PolyIsCoeff(&arr[0].p)) {
-        poly_coeff_t temp = arr[0].p.coeff;
-        free(arr);
-        return PolyFromCoeff(temp);
+    Mono *arr = (Mono *) BlockAlloc(count * sizeof(Mono));
+    memcpy(arr, monos, count * sizeof(Mono));
 
+    //Zwracany wielomian będzie posortowany względem wykładników jednomianów.
+    MonosSort(arr, count);
+
+    //Jednym przejściem sumujemy jednomiany o równych wykładnikach
+    //i pomijamy te, których współczynniki są zerowe.
+    size_t size = 0;
+    for (size_t i = 0; i < count;) {
+        Mono mono = arr[i++];
+        while (i < count && arr[i].exp == mono.exp)
+            mono.p = PolyAddOwn(&mono.p, &arr[i++].p);
+        if (!PolyIsZero(&mono.p))
+            arr[size++] = mono;
+        else
+            PolyDestroy(&mono.p);
     }
 
-    return (Poly) {.size = counter, .arr = arr};
+    return PolyFinish(arr, size);
+}
 
+Poly PolyAddMonosIn(Arena *arena, size_t count, const Mono monos[]) {
+    Arena *previous = ArenaUse(arena);
+    Poly result = PolyAddMonos(count, monos);
+    ArenaUse(previous);
+    return result;
 }
 
 Poly PolyOwnMonos(size_t count, Mono *monos) {
@@ -323,12 +846,12 @@ Poly PolyOwnMonos(size_t count, Mono *monos) {
 }
 
 Poly PolyCloneMonos(size_t count, const Mono monos[]) {
-    Mono* _monos = (Mono*) SafeMalloc (sizeof(Mono) * count);
+    Mono* _monos = (Mono*) BlockAlloc (sizeof(Mono) * count);
     for (size_t i = 0; i < count; i++) {
         _monos[i] = MonoClone(monos+i);
     }
     Poly p = PolyAddMonos(count, _monos);
-    free(_monos);
+    BlockFree(_monos);
     return p;
 }
 
@@ -349,16 +872,16 @@ static Poly PolyMulScalar(const Poly *p, long scalar) {
         return PolyZero();
 
     if (PolyIsCoeff(p)) {
-        return PolyFromCoeff(scalar * p->coeff);
+        return PolyFromCoeff((poly_coeff_t) ((unsigned long) scalar * (unsigned long) p->coeff));
     }
 
-    Mono *arr = (Mono *) SafeMalloc((p->size) * sizeof(Mono));
+    Mono *arr = (Mono *) BlockAlloc((p->size) * sizeof(Mono));
     for (size_t i = 0; i < p->size; i++) {
         arr[i].p = PolyMulScalar(&p->arr[i].p, scalar);
         arr[i].exp = p->arr[i].exp;
     }
     Poly result = PolyAddMonos(p->size, arr);
-    free(arr);
+    BlockFree(arr);
     return result;
 
 }
@@ -370,7 +893,7 @@ Poly PolyMul(const Poly *p, const Poly *q) {
         return PolyZero();
 
     if (PolyIsCoeff(p) && PolyIsCoeff(q))
-        return PolyFromCoeff(p->coeff * q->coeff);
+        return PolyFromCoeff((poly_coeff_t) ((unsigned long) p->coeff * (unsigned long) q->coeff));
 
     if (PolyIsCoeff(p))
         return PolyMulScalar(q, p->coeff);
@@ -378,29 +901,75 @@ Poly PolyMul(const Poly *p, const Poly *q) {
     if (PolyIsCoeff(q))
         return PolyMulScalar(p, q->coeff);
 
+    return MulEngine(p, q);
+}
+
+/**
+ * Mnoży wielomian przez skalar w miejscu.
+ * @param[in,out] p : wielomian @f$p@f$
+ * @param[in] scalar : skalar @f$scalar@f$
+ */
+static void PolyMulScalarInPlace(Poly *p, poly_coeff_t scalar) {
+    if (PolyIsCoeff(p)) {
+        p->coeff = (poly_coeff_t) ((unsigned long) p->coeff * (unsigned long) scalar);
+        return;
+    }
+    if (scalar == 0) {
+        PolyDestroy(p);
+        *p = PolyZero();
+        return;
+    }
 
-    int size = 0;
-    Mono *arr = (Mono *) SafeMalloc((p->size * q->size) * sizeof(Mono));
+    PolyUnshare(p);
+    //Przy przepełnieniu niektóre współczynniki mogą się wyzerować.
+    size_t size = 0;
     for (size_t i = 0; i < p->size; i++) {
-        for (size_t j = 0; j < q->size; j++) {
-            arr[size].exp = p->arr[i].exp + q->arr[j].exp;
-            arr[size].p = PolyMul(&p->arr[i].p, &q->arr[j].p);
-            size++;
-        }
+        PolyMulScalarInPlace(&p->arr[i].p, scalar);
+        if (!PolyIsZero(&p->arr[i].p))
+            p->arr[size++] = p->arr[i];
     }
-    Poly temp = PolyAddMonos(size, arr);
-    free(arr);
-    return temp;
+    *p = PolyFinish(p->arr, size);
+}
+
+Poly PolyMulOwn(Poly *p, Poly *q) {
+    assert(p != NULL && q != NULL);
 
+    if (PolyIsCoeff(p)) {
+        PolyMulScalarInPlace(q, p->coeff);
+        return *q;
+    }
+
+    if (PolyIsCoeff(q)) {
+        PolyMulScalarInPlace(p, q->coeff);
+        return *p;
+    }
+
+    Poly result = MulEngine(p, q);
+    PolyDestroy(p);
+    PolyDestroy(q);
+    return result;
+}
+
+void PolyNegInPlace(Poly *p) {
+    assert(p != NULL);
+
+    if (PolyIsCoeff(p)) {
+        p->coeff = (poly_coeff_t) (0UL - (unsigned long) p->coeff);
+        return;
+    }
+
+    PolyUnshare(p);
+    for (size_t i = 0; i < p->size; i++)
+        PolyNegInPlace(&p->arr[i].p);
 }
 
 Poly PolyNeg(const Poly *p) {
     assert(p != NULL);
 
     if (PolyIsCoeff(p))
-        return (Poly) {.coeff = -p->coeff, .arr = NULL};
+        return (Poly) {.coeff = (poly_coeff_t) (0UL - (unsigned long) p->coeff), .arr = NULL};
 
-    Mono *arr = (Mono *) SafeMalloc((p->size) * sizeof(Mono));
+    Mono *arr = (Mono *) BlockAlloc((p->size) * sizeof(Mono));
     for (size_t i = 0; i < p->size; i++) {
         arr[i].p = PolyNeg(&p->arr[i].p);
         arr[i].exp = p->arr[i].exp;
@@ -416,6 +985,12 @@ Poly PolySub(const Poly *p, const Poly *q) {
     return to_return;
 }
 
+Poly PolySubOwn(Poly *p, Poly *q) {
+    assert(p != NULL && q != NULL);
+    PolyNegInPlace(q);
+    return PolyAddOwn(p, q);
+}
+
 /**
  * Zwraca większą z dwóch liczb
  * @param[in] a : liczba @f$a@f$
@@ -464,13 +1039,13 @@ poly_exp_t PolyDeg(const Poly *p) {
 }
 
 /**
- * Podnosi liczbę całkowitą do potęgi.
+ * Podnosi liczbę całkowitą do potęgi modulo @f$2^{64}@f$.
  * @param[in] a : liczba @f$p@f$
  * @param[in] n : liczba @f$q@f$
  * @return pierwsza z liczb do potęgi drugiej z liczb
  */
-static long power(long a, long n) {
-    long acc = 1;
+static unsigned long power(unsigned long a, long n) {
+    unsigned long acc = 1;
     while (n > 0) {
         if (n % 2 == 1) {
             acc *= a;
@@ -481,16 +1056,172 @@ static long power(long a, long n) {
     return acc;
 }
 
+/**
+ * Wylicza wartość wielomianu w punkcie jednym przejściem po posortowanych
+ * wykładnikach. Współczynniki stałe są sumowane od razu, więc dla wielomianu
+ * liściowego nie potrzeba pamięci pomocniczej. Pozostałe współczynniki są
+ * mnożone przez potęgę x i sumowane naraz. Arytmetyka jest modulo @f$2^{64}@f$.
+ * @param[in] p : wielomian @f$p@f$, który nie jest współczynnikiem
+ * @param[in] x : wartość argumentu
+ * @param[in] own : czy współczynniki wolno przenieść z tablicy @p p zamiast je kopiować
+ * @return @f$p(x)@f$
+ */
+static Poly PolyAtMonos(const Poly *p, poly_coeff_t x, bool own) {
+    Poly *terms = NULL;
+    size_t count = 0;
+    unsigned long constant = 0, weight = 1;
+    poly_exp_t previous = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        //Kolejną potęgę x wyliczamy z poprzedniej, podnosząc x do różnicy wykładników.
+        weight *= power((unsigned long) x, p->arr[i].exp - previous);
+        previous = p->arr[i].exp;
+        const Poly *coeff = &p->arr[i].p;
+        if (PolyIsCoeff(coeff)) {
+            constant += weight * (unsigned long) coeff->coeff;
+            continue;
+        }
+        if (terms == NULL)
+            terms = (Poly *) SafeMalloc((p->size - i + 1) * sizeof(Poly));
+        terms[count] = own ? *coeff : PolyClone(coeff);
+        PolyMulScalarInPlace(&terms[count++], (poly_coeff_t) weight);
+    }
+    if (terms == NULL)
+        return PolyFromCoeff((poly_coeff_t) constant);
+
+    terms[count++] = PolyFromCoeff((poly_coeff_t) constant);
+    Poly result = PolySumManyOwn(count, terms);
+    free(terms);
+    return result;
+}
+
 Poly PolyAt(const Poly *p, poly_coeff_t x) {
-    if (PolyIsCoeff(p)) return PolyFromCoeff(p->coeff);
-    Poly temp = PolyZero();
+    assert(p != NULL);
+    if (PolyIsCoeff(p))
+        return PolyFromCoeff(p->coeff);
+    return PolyAtMonos(p, x, false);
+}
+
+Poly PolyAtOwn(Poly *p, poly_coeff_t x) {
+    assert(p != NULL);
+    if (PolyIsCoeff(p)) return *p;
+    //Współczynniki przenosimy tylko z tablicy, z której nikt inny nie korzysta.
+    //Współdzielona tablica zostaje nietknięta, a wielomian zwalnia tylko swoje odwołanie.
+    bool own = !BlockIsShared(p->arr) && !BlockIsInterned(p->arr);
+    Poly result = PolyAtMonos(p, x, own);
+    if (own)
+        BlockFree(p->arr);
+    else
+        PolyDestroy(p);
+    return result;
+}
+
+/**
+ * Mnoży wagi punktów przez ich argumenty podniesione do wspólnej potęgi.
+ * Wszystkie punkty są przetwarzane jednocześnie, w pętlach bez rozgałęzień,
+ * które kompilator może zwektoryzować. Arytmetyka jest modulo @f$2^{64}@f$.
+ * @param[in] n : liczba punktów
+ * @param[in] xs : argumenty
+ * @param[in] exp : wykładnik
+ * @param[in,out] weight : wagi
+ * @param[out] base : tablica pomocnicza na @p n liczb
+ */
+static void PowerMany(size_t n, const unsigned long xs[], poly_exp_t exp, unsigned long weight[],
+                      unsigned long base[]) {
+    if (exp == 0)
+        return;
+    if (exp == 1) {
+        for (size_t j = 0; j < n; j++)
+            weight[j] *= xs[j];
+        return;
+    }
+    memcpy(base, xs, n * sizeof(unsigned long));
+    while (exp > 0) {
+        if (exp % 2 == 1) {
+            for (size_t j = 0; j < n; j++)
+                weight[j] *= base[j];
+        }
+        exp /= 2;
+        if (exp > 0) {
+            for (size_t j = 0; j < n; j++)
+                base[j] *= base[j];
+        }
+    }
+}
+
+void PolyAtMany(const Poly *p, size_t n, const poly_coeff_t xs[], Poly out[]) {
+    assert(p != NULL);
+    if (n == 0)
+        return;
+    if (PolyIsCoeff(p)) {
+        for (size_t j = 0; j < n; j++)
+            out[j] = PolyFromCoeff(p->coeff);
+        return;
+    }
+
+    unsigned long *args = (unsigned long *) SafeMalloc(3 * n * sizeof(unsigned long));
+    unsigned long *weight = args + n, *base = args + 2 * n;
+    unsigned long *constant = (unsigned long *) SafeCalloc(n, sizeof(unsigned long));
+    //Przeskalowane współczynniki punktu j leżą w terms[j * (p->size + 1)] i dalej.
+    Poly *terms = (Poly *) SafeMalloc(n * (p->size + 1) * sizeof(Poly));
+    for (size_t j = 0; j < n; j++) {
+        args[j] = (unsigned long) xs[j];
+        weight[j] = 1;
+    }
+
+    size_t count = 0;
+    poly_exp_t previous = 0;
     for (size_t i = 0; i < p->size; i++) {
-        Poly temp2 = temp;
-        Poly temp3 = PolyMulScalar(&p->arr[i].p, power(x, p->arr[i].exp));
-        temp = PolyAdd(&temp2, &temp3);
-        PolyDestroy(&temp2);
-        PolyDestroy(&temp3);
+        PowerMany(n, args, p->arr[i].exp - previous, weight, base);
+        previous = p->arr[i].exp;
+        const Poly *coeff = &p->arr[i].p;
+        if (PolyIsCoeff(coeff)) {
+            for (size_t j = 0; j < n; j++)
+                constant[j] += weight[j] * (unsigned long) coeff->coeff;
+            continue;
+        }
+        for (size_t j = 0; j < n; j++) {
+            Poly *term = &terms[j * (p->size + 1) + count];
+            *term = PolyClone(coeff);
+            PolyMulScalarInPlace(term, (poly_coeff_t) weight[j]);
+        }
+        count++;
+    }
+
+    for (size_t j = 0; j < n; j++) {
+        terms[j * (p->size + 1) + count] = PolyFromCoeff((poly_coeff_t) constant[j]);
+        out[j] = PolySumManyOwn(count + 1, &terms[j * (p->size + 1)]);
+    }
+    free(terms);
+    free(constant);
+    free(args);
+}
+
+/**
+ * Wylicza wartość wielomianu zmiennych od @p level wzwyż po podstawieniu liczb
+ * za wszystkie zmienne. Arytmetyka jest modulo @f$2^{64}@f$.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] level : indeks zmiennej głównej wielomianu @p p
+ * @param[in] nvars : liczba podanych wartości zmiennych
+ * @param[in] x : wartości zmiennych
+ * @return wartość wielomianu
+ */
+static unsigned long EvalPointAt(const Poly *p, size_t level, size_t nvars, const poly_coeff_t x[]) {
+    if (PolyIsCoeff(p))
+        return (unsigned long) p->coeff;
+    if (level >= nvars)
+        return p->arr[0].exp == 0 ? EvalPointAt(&p->arr[0].p, level + 1, nvars, x) : 0;
+
+    unsigned long result = 0, weight = 1;
+    poly_exp_t previous = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        weight *= power((unsigned long) x[level], p->arr[i].exp - previous);
+        previous = p->arr[i].exp;
+        result += weight * EvalPointAt(&p->arr[i].p, level + 1, nvars, x);
     }
-    return temp;
+    return result;
 }
 
+poly_coeff_t PolyEvalPoint(const Poly *p, size_t nvars, const poly_coeff_t x[]) {
+    assert(p != NULL);
+    return (poly_coeff_t) EvalPointAt(p, 0, nvars, x);
+}
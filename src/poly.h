@@ -21,6 +21,8 @@ typedef int poly_exp_t;
 
 struct Mono;
 
+struct Arena;
+
 /**
  * To jest struktura przechowująca wielomian.
  * Wielomian jest albo liczbą całkowitą, czyli wielomianem stałym
@@ -125,14 +127,16 @@ static inline void MonoDestroy(Mono *m) {
 }
 
 /**
- * Robi pełną, głęboką kopię wielomianu.
+ * Robi kopię wielomianu. Tablice jednomianów są niezmienne i mają licznik
+ * odwołań, więc kopia współdzieli je z oryginałem i powstaje w czasie stałym.
+ * Tablice z aren oraz kopie tworzone przy ustawionej arenie są kopiowane w głąb.
  * @param[in] p : wielomian
  * @return skopiowany wielomian
  */
 Poly PolyClone(const Poly *p);
 
 /**
- * Robi pełną, głęboką kopię jednomianu.
+ * Robi kopię jednomianu, tak jak PolyClone.
  * @param[in] m : jednomian
  * @return skopiowany jednomian
  */
@@ -140,6 +144,16 @@ static inline Mono MonoClone(const Mono *m) {
   return (Mono) {.p = PolyClone(&m->p), .exp = m->exp};
 }
 
+/**
+ * Robi pełną, głęboką kopię wielomianu, której wszystkie tablice jednomianów
+ * są przydzielone z areny @p arena. Taka kopia jest zwalniana razem z areną,
+ * bez wywoływania PolyDestroy.
+ * @param[in] arena : arena
+ * @param[in] p : wielomian
+ * @return skopiowany wielomian
+ */
+Poly PolyCloneIn(struct Arena *arena, const Poly *p);
+
 /**
  * Dodaje dwa wielomiany.
  * @param[in] p : wielomian @f$p@f$
@@ -157,6 +171,18 @@ Poly PolyAdd(const Poly *p, const Poly *q);
  */
 Poly PolyAddMonos(size_t count, const Mono monos[]);
 
+/**
+ * Sumuje listę jednomianów i tworzy z nich wielomian, którego nowe tablice
+ * jednomianów są przydzielone z areny @p arena.
+ * Przejmuje na własność zawartość tablicy @p monos. Żeby wynik mógł być
+ * zwolniony razem z areną, współczynniki jednomianów też powinny pochodzić z tej areny.
+ * @param[in] arena : arena
+ * @param[in] count : liczba jednomianów
+ * @param[in] monos : tablica jednomianów
+ * @return wielomian będący sumą jednomianów
+ */
+Poly PolyAddMonosIn(struct Arena *arena, size_t count, const Mono monos[]);
+
 /**
  * Mnoży dwa wielomiany.
  * @param[in] p : wielomian @f$p@f$
@@ -165,6 +191,60 @@ Poly PolyAddMonos(size_t count, const Mono monos[]);
  */
 Poly PolyMul(const Poly *p, const Poly *q);
 
+/**
+ * Dodaje dwa wielomiany. Przejmuje na własność zawartość struktur wskazywanych
+ * przez @p p i @p q: ich poddrzewa są przenoszone do wyniku zamiast kopiowania,
+ * a same wielomiany nie mogą być później używane ani usuwane.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+Poly PolyAddOwn(Poly *p, Poly *q);
+
+/**
+ * Odejmuje wielomian od wielomianu. Przejmuje na własność zawartość struktur
+ * wskazywanych przez @p p i @p q, tak jak PolyAddOwn.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p - q@f$
+ */
+Poly PolySubOwn(Poly *p, Poly *q);
+
+/**
+ * Dodaje wiele wielomianów naraz. Jednomiany wszystkich składników są
+ * scalane w jednym przejściu, a współczynniki jednomianów o równych
+ * wykładnikach są sumowane tak samo, rekurencyjnie.
+ * @param[in] n : liczba wielomianów
+ * @param[in] ps : tablica wielomianów
+ * @return @f$ps[0] + ps[1] + \ldots + ps[n - 1]@f$
+ */
+Poly PolySumMany(size_t n, const Poly ps[]);
+
+/**
+ * Dodaje wiele wielomianów naraz, tak jak PolySumMany. Przejmuje na własność
+ * zawartość wszystkich wielomianów z tablicy @p ps, tak jak PolyAddOwn;
+ * sama tablica pozostaje własnością wołającego.
+ * @param[in] n : liczba wielomianów
+ * @param[in] ps : tablica wielomianów
+ * @return @f$ps[0] + ps[1] + \ldots + ps[n - 1]@f$
+ */
+Poly PolySumManyOwn(size_t n, Poly ps[]);
+
+/**
+ * Mnoży dwa wielomiany. Przejmuje na własność zawartość struktur wskazywanych
+ * przez @p p i @p q. Mnożenie przez współczynnik odbywa się w miejscu.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+Poly PolyMulOwn(Poly *p, Poly *q);
+
+/**
+ * Zamienia wielomian na przeciwny w miejscu.
+ * @param[in] p : wielomian @f$p@f$
+ */
+void PolyNegInPlace(Poly *p);
+
 /**
  * Zwraca przeciwny wielomian.
  * @param[in] p : wielomian @f$p@f$
@@ -220,6 +300,38 @@ bool PolyIsEq(const Poly *p, const Poly *q);
  */
 Poly PolyAt(const Poly *p, poly_coeff_t x);
 
+/**
+ * Wylicza wartość wielomianu w punkcie @p x, tak jak PolyAt.
+ * Przejmuje na własność zawartość struktury wskazywanej przez @p p
+ * i przenosi jej poddrzewa do wyniku zamiast kopiowania.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] x : wartość argumentu @f$x@f$
+ * @return @f$p(x, x_0, x_1, \ldots)@f$
+ */
+Poly PolyAtOwn(Poly *p, poly_coeff_t x);
+
+/**
+ * Wylicza wartości wielomianu w wielu punktach naraz, tak jak kolejne
+ * wywołania PolyAt, ale przechodząc wielomian tylko raz. Potęgi argumentów
+ * są wyliczane jednocześnie dla wszystkich punktów.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] n : liczba punktów, być może zerowa
+ * @param[in] xs : tablica @p n wartości argumentu
+ * @param[out] out : tablica @p n wielomianów, do której zostaną wpisane
+ * wartości @f$p(xs_j, x_0, x_1, \ldots)@f$
+ */
+void PolyAtMany(const Poly *p, size_t n, const poly_coeff_t xs[], Poly out[]);
+
+/**
+ * Wylicza wartość wielomianu po podstawieniu liczb za wszystkie zmienne.
+ * Za zmienne o indeksach nie mniejszych od @p nvars podstawiane jest zero.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] nvars : liczba podanych wartości zmiennych
+ * @param[in] x : tablica @p nvars wartości zmiennych @f$x_0, x_1, \ldots@f$
+ * @return @f$p(x_0, x_1, \ldots)@f$
+ */
+poly_coeff_t PolyEvalPoint(const Poly *p, size_t nvars, const poly_coeff_t x[]);
+
 /**
  * Składanie wielomianów.
  */
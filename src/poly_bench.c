@@ -0,0 +1,272 @@
+/** @file
+  Pomiar czasu mnożenia wielomianów różnymi metodami, wyliczania wartości
+  wielomianów wielu zmiennych oraz złożenia w jednym i w wielu wątkach.
+  Uruchomienie: poly_bench [maksymalna liczba jednomianów].
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "poly.h"
+#include "mul.h"
+#include "memory.h"
+#include "program.h"
+#include "pool.h"
+
+/** Minimalny czas jednego pomiaru w sekundach. */
+#define MIN_MEASURE_TIME 0.05
+
+/** Liczba zmiennych wielomianu w pomiarze wyliczania wartości. */
+#define EVAL_VARS 3
+
+/** Liczba punktów, w których wyliczamy wartość w jednym powtórzeniu pomiaru. */
+#define EVAL_POINTS 64
+
+/** Liczba wątków w pomiarze równoległego złożenia. */
+#define COMPOSE_THREADS 4
+
+/**
+ * Tworzy gęsty wielomian jednej zmiennej o losowych współczynnikach.
+ * @param[in] size : liczba jednomianów
+ * @return wielomian
+ */
+static Poly RandomDensePoly(size_t size) {
+    Mono *monos = (Mono *) SafeMalloc(size * sizeof(Mono));
+    for (size_t i = 0; i < size; i++) {
+        Poly coeff = PolyFromCoeff(rand() % 1999 - 999);
+        if (PolyIsZero(&coeff))
+            coeff = PolyFromCoeff(1);
+        monos[i] = MonoFromPoly(&coeff, (poly_exp_t) i);
+    }
+    return PolyOwnMonos(size, monos);
+}
+
+/**
+ * Tworzy rzadki wielomian jednej zmiennej o losowych wykładnikach i współczynnikach.
+ * @param[in] size : liczba jednomianów
+ * @return wielomian
+ */
+static Poly RandomSparsePoly(size_t size) {
+    Mono *monos = (Mono *) SafeMalloc(size * sizeof(Mono));
+    for (size_t i = 0; i < size; i++) {
+        Poly coeff = PolyFromCoeff(rand() % 999 + 1);
+        monos[i] = MonoFromPoly(&coeff, rand() % (1 << 20));
+    }
+    return PolyOwnMonos(size, monos);
+}
+
+/**
+ * Tworzy wielomian zadanej liczby zmiennych o losowych wykładnikach i współczynnikach.
+ * @param[in] vars : liczba zmiennych
+ * @param[in] size : liczba jednomianów względem każdej zmiennej
+ * @return wielomian
+ */
+static Poly RandomNestedPoly(size_t vars, size_t size) {
+    if (vars == 0)
+        return PolyFromCoeff(rand() % 1999 - 999);
+    Mono *monos = (Mono *) SafeMalloc(size * sizeof(Mono));
+    for (size_t i = 0; i < size; i++) {
+        Poly coeff = RandomNestedPoly(vars - 1, size);
+        monos[i] = MonoFromPoly(&coeff, rand() % 64);
+    }
+    return PolyOwnMonos(size, monos);
+}
+
+/** Suma kontrolna wyników, która nie pozwala kompilatorowi pominąć obliczeń. */
+static volatile poly_coeff_t eval_sink;
+
+/**
+ * To jest typ wyznaczający sposób wyliczania wartości wielomianu w pomiarze.
+ */
+typedef enum EvalMethod {
+    EVAL_AT, ///< kolejne wywołania PolyAt dla każdej zmiennej
+    EVAL_POINT, ///< PolyEvalPoint
+    EVAL_PROGRAM ///< PolyProgramEval na programie z PolyCompile
+} EvalMethod;
+
+/**
+ * Mierzy średni czas wyliczenia wartości wielomianu w jednym punkcie.
+ * @param[in] p : wielomian
+ * @param[in] program : program wyliczający wartość @p p
+ * @param[in] points : tablica EVAL_POINTS punktów po EVAL_VARS współrzędnych
+ * @param[in] method : sposób wyliczania wartości
+ * @return czas wyliczenia wartości w jednym punkcie w nanosekundach
+ */
+static double MeasureEval(const Poly *p, const PolyProgram *program, const poly_coeff_t *points, EvalMethod method) {
+    size_t reps = 0;
+    clock_t start = clock();
+    double elapsed = 0;
+    poly_coeff_t checksum = 0;
+    do {
+        for (size_t j = 0; j < EVAL_POINTS; j++) {
+            const poly_coeff_t *x = points + j * EVAL_VARS;
+            if (method == EVAL_AT) {
+                Poly value = PolyClone(p);
+                for (size_t v = 0; v < EVAL_VARS; v++) {
+                    Poly next = PolyAt(&value, x[v]);
+                    PolyDestroy(&value);
+                    value = next;
+                }
+                checksum += value.coeff;
+            } else if (method == EVAL_POINT) {
+                checksum += PolyEvalPoint(p, EVAL_VARS, x);
+            } else {
+                checksum += PolyProgramEval(program, x);
+            }
+        }
+        reps++;
+        elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+    } while (elapsed < MIN_MEASURE_TIME);
+    eval_sink = checksum;
+    return elapsed * 1e9 / (reps * EVAL_POINTS);
+}
+
+/**
+ * Mierzy średni czas mnożenia dwóch wielomianów zadaną metodą.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] mode : metoda mnożenia
+ * @param[in] cutoff : próg algorytmu Karatsuby
+ * @param[in] ntt_cutoff : próg szybkiej transformaty teorioliczbowej
+ * @return czas jednego mnożenia w mikrosekundach
+ */
+static double Measure(const Poly *p, const Poly *q, MulMode mode, size_t cutoff, size_t ntt_cutoff) {
+    MulSetMode(mode);
+    MulSetKaratsubaCutoff(cutoff);
+    MulSetNttCutoff(ntt_cutoff);
+    size_t reps = 0;
+    clock_t start = clock();
+    double elapsed = 0;
+    do {
+        Poly r = PolyMul(p, q);
+        PolyDestroy(&r);
+        reps++;
+        elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+    } while (elapsed < MIN_MEASURE_TIME);
+    MulSetMode(MUL_AUTO);
+    MulSetKaratsubaCutoff(KARATSUBA_DEFAULT_CUTOFF);
+    MulSetNttCutoff(NTT_DEFAULT_CUTOFF);
+    return elapsed * 1e6 / reps;
+}
+
+/**
+ * Zwraca czas zegara ściennego. Przy wielu wątkach clock sumuje czas
+ * procesora wszystkich wątków, więc nie nadaje się do pomiaru przyspieszenia.
+ * @return czas w sekundach
+ */
+static double WallTime(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double) now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * Mierzy średni czas złożenia wielomianu z dwoma wielomianami przy zadanej liczbie wątków.
+ * @param[in] p : składany wielomian
+ * @param[in] q : dwa podstawiane wielomiany
+ * @param[in] threads : liczba wątków
+ * @return czas jednego złożenia w milisekundach
+ */
+static double MeasureCompose(const Poly *p, const Poly q[], size_t threads) {
+    PoolSetThreads(threads);
+    size_t reps = 0;
+    double start = WallTime(), elapsed = 0;
+    do {
+        Poly r = PolyCompose(p, 2, q);
+        PolyDestroy(&r);
+        reps++;
+        elapsed = WallTime() - start;
+    } while (elapsed < MIN_MEASURE_TIME);
+    PoolSetThreads(1);
+    return elapsed * 1e3 / reps;
+}
+
+/**
+ * Wypisuje czasy mnożenia kopcem, metodą szkolną, algorytmem Karatsuby
+ * i szybką transformatą teorioliczbową dla coraz większych wielomianów,
+ * punkty, od których algorytm Karatsuby jest szybszy od metody szkolnej,
+ * a transformata od algorytmu Karatsuby, oraz czasy dla różnych progów algorytmu Karatsuby.
+ * Na koniec wypisuje czasy wyliczania wartości wielomianu trzech zmiennych
+ * kolejnymi wywołaniami PolyAt, funkcją PolyEvalPoint i skompilowanym programem
+ * oraz czasy złożenia wielomianu dwóch zmiennych w jednym wątku i w COMPOSE_THREADS wątkach.
+ * @param[in] argc : liczba argumentów
+ * @param[in] argv : argumenty
+ * @return kod wyjścia
+ */
+int main(int argc, char *argv[]) {
+    size_t max_size = argc > 1 ? strtoull(argv[1], NULL, 10) : 4096;
+    srand(2021);
+
+    printf("%8s %14s %14s %14s %14s\n", "monos", "heap [us]", "classical [us]", "karatsuba [us]", "ntt [us]");
+    size_t crossover = 0, ntt_crossover = 0;
+    for (size_t size = 8; size <= max_size; size *= 2) {
+        Poly p = RandomDensePoly(size);
+        Poly q = RandomDensePoly(size);
+        //Scalanie kopcem jest kwadratowe, więc dla dużych wielomianów go pomijamy.
+        if (size <= 1024)
+            printf("%8zu %14.1f", size, Measure(&p, &q, MUL_SPARSE, SIZE_MAX, SIZE_MAX));
+        else
+            printf("%8zu %14s", size, "-");
+        double classical = Measure(&p, &q, MUL_DENSE, SIZE_MAX, SIZE_MAX);
+        double karatsuba = Measure(&p, &q, MUL_DENSE, KARATSUBA_DEFAULT_CUTOFF, SIZE_MAX);
+        double ntt = Measure(&p, &q, MUL_DENSE, KARATSUBA_DEFAULT_CUTOFF, 1);
+        printf(" %14.1f %14.1f %14.1f\n", classical, karatsuba, ntt);
+        //Punkt przecięcia to najmniejszy rozmiar, od którego algorytm Karatsuby jest już zawsze szybszy.
+        if (karatsuba >= classical)
+            crossover = 0;
+        else if (crossover == 0)
+            crossover = size;
+        if (ntt >= karatsuba)
+            ntt_crossover = 0;
+        else if (ntt_crossover == 0)
+            ntt_crossover = size;
+        PolyDestroy(&p);
+        PolyDestroy(&q);
+    }
+    if (crossover != 0)
+        printf("karatsuba faster than classical from %zu monomials\n", crossover);
+    if (ntt_crossover != 0)
+        printf("ntt faster than karatsuba from %zu monomials\n", ntt_crossover);
+
+    printf("\n%8s %14s\n", "cutoff", "time [us]");
+    Poly p = RandomDensePoly(max_size);
+    Poly q = RandomDensePoly(max_size);
+    for (size_t cutoff = 4; cutoff <= 256; cutoff *= 2)
+        printf("%8zu %14.1f\n", cutoff, Measure(&p, &q, MUL_DENSE, cutoff, SIZE_MAX));
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+
+    printf("\n%8s %14s %14s %14s %14s\n", "monos", "compile [us]", "at [ns]", "eval [ns]", "program [ns]");
+    poly_coeff_t points[EVAL_POINTS * EVAL_VARS];
+    for (size_t i = 0; i < EVAL_POINTS * EVAL_VARS; i++)
+        points[i] = rand() % 201 - 100;
+    for (size_t size = 2; size <= 32; size *= 2) {
+        Poly r = RandomNestedPoly(EVAL_VARS, size);
+        clock_t start = clock();
+        PolyProgram *program = PolyCompile(&r, EVAL_VARS);
+        double compile = (double) (clock() - start) * 1e6 / CLOCKS_PER_SEC;
+        printf("%8zu %14.1f %14.1f %14.1f %14.1f\n", size * size * size, compile,
+               MeasureEval(&r, program, points, EVAL_AT),
+               MeasureEval(&r, program, points, EVAL_POINT),
+               MeasureEval(&r, program, points, EVAL_PROGRAM));
+        PolyProgramFree(program);
+        PolyDestroy(&r);
+    }
+
+    printf("\n%8s %14s %14s\n", "monos", "1 thread [ms]", "threads [ms]");
+    Poly q_compose[] = {RandomSparsePoly(3), RandomDensePoly(4)};
+    for (size_t size = 2; size <= 8; size *= 2) {
+        Poly r = RandomNestedPoly(2, size);
+        printf("%8zu %14.2f %14.2f\n", size * size, MeasureCompose(&r, q_compose, 1),
+               MeasureCompose(&r, q_compose, COMPOSE_THREADS));
+        PolyDestroy(&r);
+    }
+    PolyDestroy(&q_compose[0]);
+    PolyDestroy(&q_compose[1]);
+    return 0;
+}
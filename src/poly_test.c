@@ -2,13 +2,29 @@
 #undef NDEBUG
 #endif
 
+//To jest makro potrzebne do działania funkcji fileno.
+#define _POSIX_C_SOURCE 200809L
+
 #include "poly.h"
+#include "memory.h"
+#include "intern.h"
+#include "program.h"
+#include "dist.h"
+#include "lazy.h"
+#include "reader.h"
+#include "mul.h"
+#include "pool.h"
+#include "parser.h"
+#include "stack.h"
 #include <assert.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 /** DANE DO TESTÓW **/
 
@@ -3967,6 +3983,1091 @@ static bool MemoryFreeTest(void) {
   return res;
 }
 
+/**
+ * Sprawdza wielomiany budowane w arenie. Są one zwalniane razem z areną,
+ * bez wywoływania PolyDestroy.
+ */
+static bool ArenaTest(void) {
+  bool res = true;
+  Arena *arena = ArenaNew();
+  Poly p = P(P(C(1), 1, C(2), 3), 0, C(5), 4);
+
+  Poly a = PolyCloneIn(arena, &p);
+  res &= PolyIsEq(&a, &p);
+
+  Mono m[] = {M(PolyCloneIn(arena, &p), 1), M(PolyCloneIn(arena, &p), 1)};
+  Poly b = PolyAddMonosIn(arena, 2, m);
+  Poly expected_b = P(PolyAdd(&p, &p), 1);
+  res &= PolyIsEq(&b, &expected_b);
+
+  Arena *previous = ArenaUse(arena);
+  Poly c = PolyMul(&a, &b);
+  Poly d = PolyAdd(&c, &a);
+  ArenaUse(previous);
+  Poly temp = PolyMul(&p, &expected_b);
+  Poly expected_d = PolyAdd(&temp, &p);
+  res &= PolyIsEq(&d, &expected_d);
+  PolyDestroy(&temp);
+  PolyDestroy(&expected_b);
+  PolyDestroy(&expected_d);
+
+  ArenaReset(arena);
+  a = PolyCloneIn(arena, &p);
+  res &= PolyIsEq(&a, &p);
+
+  //Scalanie z pustymi arenami i wielokrotne scalanie zachowuje wszystkie bloki.
+  Arena *empty = ArenaNew();
+  res &= ArenaBytes(empty) == 0;
+  ArenaMerge(arena, empty);
+  empty = ArenaNew();
+  size_t bytes = ArenaBytes(arena);
+  ArenaMerge(empty, arena);
+  res &= ArenaBytes(empty) == bytes;
+  arena = empty;
+  for (size_t i = 0; i < 3; i++) {
+    Arena *other = ArenaNew();
+    Poly e = PolyCloneIn(other, &p);
+    bytes += ArenaBytes(other);
+    ArenaMerge(arena, other);
+    res &= PolyIsEq(&e, &p) && PolyIsEq(&a, &p);
+  }
+  res &= ArenaBytes(arena) == bytes;
+
+  ArenaDestroy(arena);
+  PolyDestroy(&p);
+  return res;
+}
+
+/**
+ * Sprawdza, czy małe tablice jednomianów są ponownie używane przez pulę.
+ */
+static bool BlockPoolTest(void) {
+  Poly p = P(C(1), 1, C(2), 3);
+  Poly q = PolyNeg(&p);
+  PolyDestroy(&q);
+  BlockPoolStats before = BlockPoolGetStats();
+  for (int i = 0; i < 100; ++i) {
+    q = PolyNeg(&p);
+    PolyDestroy(&q);
+  }
+  BlockPoolStats after = BlockPoolGetStats();
+  PolyDestroy(&p);
+  BlockPoolRelease();
+  return after.hits - before.hits == 100 && after.misses == before.misses;
+}
+
+/**
+ * Sprawdza, czy operacje przejmujące argumenty na własność dają te same wyniki
+ * co ich odpowiedniki kopiujące.
+ */
+static bool OwnTest(void) {
+  bool res = true;
+  Poly polys[] = {
+    C(0),
+    C(7),
+    P(C(1), 0, C(2), 1),
+    P(C(-1), 0, C(-2), 1),
+    P(P(C(1), 0, C(2), 1), 0, C(3), 2),
+    P(C(-3), 2, P(C(4), 1), 5),
+    P(C(LONG_MIN), 1, C(1L << 62), 3),
+  };
+  for (size_t i = 0; i < sizeof(polys) / sizeof(polys[0]); ++i) {
+    for (size_t j = 0; j < sizeof(polys) / sizeof(polys[0]); ++j) {
+      Poly *p = &polys[i], *q = &polys[j];
+      Poly expected, a, b, got;
+
+      expected = PolyAdd(p, q);
+      a = PolyClone(p);
+      b = PolyClone(q);
+      got = PolyAddOwn(&a, &b);
+      res &= PolyIsEq(&got, &expected);
+      PolyDestroy(&got);
+      PolyDestroy(&expected);
+
+      expected = PolySub(p, q);
+      a = PolyClone(p);
+      b = PolyClone(q);
+      got = PolySubOwn(&a, &b);
+      res &= PolyIsEq(&got, &expected);
+      PolyDestroy(&got);
+      PolyDestroy(&expected);
+
+      expected = PolyMul(p, q);
+      a = PolyClone(p);
+      b = PolyClone(q);
+      got = PolyMulOwn(&a, &b);
+      res &= PolyIsEq(&got, &expected);
+      PolyDestroy(&got);
+      PolyDestroy(&expected);
+    }
+    Poly x = C(4);
+    Poly expected = PolyMul(&polys[i], &x);
+    Poly got = PolyClone(&polys[i]);
+    Poly scaled = PolyMulOwn(&x, &got);
+    res &= PolyIsEq(&scaled, &expected);
+    PolyDestroy(&scaled);
+    PolyDestroy(&expected);
+
+    expected = PolyNeg(&polys[i]);
+    got = PolyClone(&polys[i]);
+    PolyNegInPlace(&got);
+    res &= PolyIsEq(&got, &expected);
+    PolyDestroy(&got);
+    PolyDestroy(&expected);
+
+    expected = PolyAt(&polys[i], -2);
+    got = PolyClone(&polys[i]);
+    Poly at = PolyAtOwn(&got, -2);
+    res &= PolyIsEq(&at, &expected);
+    PolyDestroy(&at);
+    PolyDestroy(&expected);
+  }
+  for (size_t i = 0; i < sizeof(polys) / sizeof(polys[0]); ++i)
+    PolyDestroy(&polys[i]);
+  return res;
+}
+
+/**
+ * Sprawdza, czy kopie współdzielą tablice jednomianów, a zmiany w miejscu
+ * nie są widoczne w innych kopiach.
+ */
+static bool SharingTest(void) {
+  bool res = true;
+  Poly p = P(P(C(1), 0, C(2), 1), 0, C(3), 2);
+  Poly expected = PolyClone(&p);
+  Poly q = PolyClone(&p);
+  res &= q.arr == p.arr;
+
+  Poly r = PolyClone(&q);
+  PolyNegInPlace(&r);
+  res &= PolyIsEq(&q, &expected);
+  Poly neg = PolyNeg(&expected);
+  res &= PolyIsEq(&r, &neg);
+
+  Poly s = PolyClone(&q);
+  Poly one = C(1);
+  Poly sum = PolyAddOwn(&s, &one);
+  res &= PolyIsEq(&q, &expected);
+  res &= !PolyIsEq(&sum, &expected);
+
+  Poly t = PolyAdd(&p, &r);
+  res &= PolyIsZero(&t);
+  Poly x = P(C(1), 3);
+  Poly u = PolyAdd(&p, &x);
+  res &= u.arr[0].p.arr == p.arr[0].p.arr;
+
+  PolyDestroy(&p);
+  res &= PolyIsEq(&q, &expected);
+  PolyDestroy(&q);
+  PolyDestroy(&r);
+  PolyDestroy(&sum);
+  PolyDestroy(&neg);
+  PolyDestroy(&t);
+  PolyDestroy(&u);
+  PolyDestroy(&x);
+  PolyDestroy(&expected);
+  return res;
+}
+
+/**
+ * Sprawdza tablicę wielomianów w postaci kanonicznej i funkcję skrótu.
+ */
+static bool InternTest(void) {
+  bool res = true;
+  size_t before = PolyInternCount();
+  Poly p = P(P(C(1), 0, C(2), 1), 0, P(C(3), 4), 2);
+  Poly q = P(P(C(1), 0, C(2), 1), 0, P(C(3), 4), 2);
+  Poly r = P(P(C(1), 0, C(2), 1), 0, P(C(3), 5), 2);
+  res &= PolyHash(&p) == PolyHash(&q);
+  res &= PolyHash(&p) != PolyHash(&r);
+
+  Poly a = PolyIntern(&p);
+  Poly b = PolyIntern(&q);
+  Poly c = PolyIntern(&r);
+  res &= a.arr == b.arr && a.arr != c.arr;
+  res &= a.arr[0].p.arr == c.arr[0].p.arr;
+  res &= PolyIsEq(&a, &b) && !PolyIsEq(&a, &c);
+  res &= PolyInternCount() == before + 5;
+
+  Poly d = PolyClone(&b);
+  PolyNegInPlace(&d);
+  Poly expected = P(P(C(1), 0, C(2), 1), 0, P(C(3), 4), 2);
+  res &= PolyIsEq(&b, &expected);
+
+  PolyDestroy(&a);
+  PolyDestroy(&b);
+  PolyDestroy(&c);
+  PolyDestroy(&d);
+  PolyDestroy(&expected);
+  res &= PolyInternCount() == before;
+  PolyInternRelease();
+  return res;
+}
+
+/**
+ * Sprawdza złożenie wielomianów, w tym podstawianie zera za brakujące zmienne
+ * i powtarzające się różnice wykładników.
+ */
+static bool ComposeTest(void) {
+  bool res = true;
+  Poly p = P(C(5), 0, C(1), 1, P(C(1), 0, C(1), 2), 3);
+  Poly q[] = {P(C(1), 0, C(1), 1), P(C(1), 1)};
+
+  Poly r = PolyCompose(&p, 2, q);
+  Poly expected = P(C(7), 0, C(4), 1, C(4), 2, C(4), 3, C(3), 4, C(1), 5);
+  res &= PolyIsEq(&r, &expected);
+  PolyDestroy(&r);
+  PolyDestroy(&expected);
+
+  r = PolyCompose(&p, 1, q);
+  expected = P(C(7), 0, C(4), 1, C(3), 2, C(1), 3);
+  res &= PolyIsEq(&r, &expected);
+  PolyDestroy(&r);
+  PolyDestroy(&expected);
+
+  r = PolyCompose(&p, 0, q);
+  res &= PolyIsEq(&r, &(Poly) {.coeff = 5, .arr = NULL});
+  PolyDestroy(&r);
+
+  Poly s = P(C(1), 2, C(1), 4, C(1), 6, C(1), 8);
+  r = PolyCompose(&s, 1, q);
+  Poly expected_s = PolyZero();
+  for (poly_exp_t e = 2; e <= 8; e += 2) {
+    Poly power = C(1);
+    for (poly_exp_t i = 0; i < e; i++) {
+      Poly temp = PolyMul(&power, &q[0]);
+      PolyDestroy(&power);
+      power = temp;
+    }
+    Poly temp = PolyAddOwn(&expected_s, &power);
+    expected_s = temp;
+  }
+  res &= PolyIsEq(&r, &expected_s);
+  PolyDestroy(&r);
+  PolyDestroy(&expected_s);
+
+  PolyDestroy(&s);
+  PolyDestroy(&p);
+  PolyDestroy(&q[0]);
+  PolyDestroy(&q[1]);
+  return res;
+}
+
+/**
+ * Sprawdza wyliczanie wartości wielomianu w wielu punktach naraz
+ * oraz po podstawieniu liczb za wszystkie zmienne.
+ */
+static bool AtManyTest(void) {
+  bool res = true;
+  Poly p = P(P(C(1), 0, C(-2), 3), 0, C(5), 1, P(P(C(1), 2), 1, C(7), 4), 3, C(LONG_MAX), 64);
+  const poly_coeff_t xs[] = {0, 1, -1, 2, -3, 10, LONG_MIN, 123456789};
+  size_t n = sizeof(xs) / sizeof(xs[0]);
+  Poly out[sizeof(xs) / sizeof(xs[0])];
+
+  PolyAtMany(&p, 0, xs, out);
+  PolyAtMany(&p, n, xs, out);
+  for (size_t j = 0; j < n; ++j) {
+    Poly expected = PolyAt(&p, xs[j]);
+    res &= PolyIsEq(&out[j], &expected);
+    PolyDestroy(&expected);
+    PolyDestroy(&out[j]);
+  }
+
+  for (size_t j = 0; j + 2 < n; ++j) {
+    Poly a = PolyAt(&p, xs[j]);
+    Poly b = PolyAt(&a, xs[j + 1]);
+    Poly c = PolyAt(&b, xs[j + 2]);
+    res &= PolyIsCoeff(&c) && PolyEvalPoint(&p, 3, xs + j) == c.coeff;
+    Poly d = PolyAt(&b, 0);
+    res &= PolyIsCoeff(&d) && PolyEvalPoint(&p, 2, xs + j) == d.coeff;
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+    PolyDestroy(&c);
+    PolyDestroy(&d);
+  }
+
+  PolyDestroy(&p);
+  return res;
+}
+
+/**
+ * Sprawdza, czy skompilowany program wylicza te same wartości co PolyEvalPoint.
+ */
+static bool ProgramTest(void) {
+  bool res = true;
+  Poly polys[] = {
+    C(-17),
+    P(C(3), 5),
+    P(P(C(1), 0, C(-2), 3), 0, C(5), 1, P(P(C(1), 2), 1, C(7), 4), 3, C(LONG_MAX), 64),
+    P(P(P(C(2), 1, C(3), 7), 2, C(-1), 9), 1, P(C(4), 3), 6),
+  };
+  const poly_coeff_t points[][3] = {{0, 0, 0}, {1, -1, 2}, {-3, 10, 7}, {LONG_MIN, 3, -5}, {123456789, 2, 1}};
+  for (size_t i = 0; i < sizeof(polys) / sizeof(polys[0]); ++i) {
+    for (size_t nvars = 0; nvars <= 3; ++nvars) {
+      PolyProgram *program = PolyCompile(&polys[i], nvars);
+      for (size_t j = 0; j < sizeof(points) / sizeof(points[0]); ++j)
+        res &= PolyProgramEval(program, points[j]) == PolyEvalPoint(&polys[i], nvars, points[j]);
+      PolyProgramFree(program);
+    }
+    PolyDestroy(&polys[i]);
+  }
+  return res;
+}
+
+/**
+ * Sprawdza szybkie ścieżki dla wielomianów, których współczynniki są liczbami.
+ */
+static bool LeafTest(void) {
+  bool res = true;
+  Poly p = P(C(LONG_MAX), 0, C(3), 2, C(-1), 7);
+  Poly q = P(C(1), 0, C(-3), 2, C(5), 9);
+  Poly sum = PolyAdd(&p, &q);
+  Poly expected = P(C(LONG_MIN), 0, C(-1), 7, C(5), 9);
+  res &= PolyIsEq(&sum, &expected);
+  PolyDestroy(&sum);
+  PolyDestroy(&expected);
+
+  Poly r = P(C(-3), 2);
+  Poly s = P(C(3), 2, C(1), 5);
+  sum = PolyAdd(&r, &s);
+  expected = P(C(1), 5);
+  res &= PolyIsEq(&sum, &expected);
+  PolyDestroy(&sum);
+  PolyDestroy(&expected);
+
+  Poly prod = PolyMul(&p, &q);
+  Poly expected_prod = P(C(LONG_MAX), 0, C((long) (3 - 3UL * LONG_MAX)), 2, C(-9), 4, C(-1), 7,
+                         C((long) (5UL * LONG_MAX + 3)), 9, C(15), 11, C(-5), 16);
+  res &= PolyIsEq(&prod, &expected_prod);
+  PolyDestroy(&prod);
+  PolyDestroy(&expected_prod);
+
+  Poly at = PolyAt(&q, 2);
+  res &= PolyIsCoeff(&at) && at.coeff == 1 - 12 + 5 * 512;
+
+  Mono long_monos[43];
+  for (size_t i = 0; i < 40; ++i)
+    long_monos[i] = M(C(1), 2 * (poly_exp_t) i);
+  Poly long_p = PolyAddMonos(40, long_monos);
+  Poly short_q = P(C(2), 21, C(-1), 40, C(3), 200);
+  long_monos[40] = M(C(2), 21);
+  long_monos[41] = M(C(-1), 40);
+  long_monos[42] = M(C(3), 200);
+  Poly long_sum = PolyAdd(&long_p, &short_q);
+  for (size_t i = 0; i < 40; ++i)
+    long_monos[i] = M(C(1), 2 * (poly_exp_t) i);
+  expected = PolyAddMonos(43, long_monos);
+  res &= PolyIsEq(&long_sum, &expected) && long_sum.size == 41;
+  PolyDestroy(&long_sum);
+  long_sum = PolyAdd(&short_q, &long_p);
+  res &= PolyIsEq(&long_sum, &expected);
+  PolyDestroy(&long_sum);
+  PolyDestroy(&expected);
+  PolyDestroy(&long_p);
+  PolyDestroy(&short_q);
+
+  Arena *arena = ArenaNew();
+  Poly copy = PolyCloneIn(arena, &p);
+  res &= PolyIsEq(&copy, &p) && copy.arr != p.arr;
+  ArenaDestroy(arena);
+
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  PolyDestroy(&r);
+  PolyDestroy(&s);
+  return res;
+}
+
+/**
+ * Sprawdza przejścia do reprezentacji rozproszonej i z powrotem,
+ * dodawanie w tej reprezentacji oraz wyliczanie stopni.
+ */
+static bool DistTest(void) {
+  bool res = true;
+  Poly polys[] = {
+    C(0),
+    C(-17),
+    P(C(3), 5),
+    P(P(C(1), 0, C(-2), 3), 0, C(5), 1, P(P(C(1), 2), 1, C(7), 4), 3, C(LONG_MAX), 64),
+    P(P(P(C(2), 1, C(3), 7), 2, C(-1), 9), 1, P(C(4), 3), 6),
+    P(P(P(P(C(1), 1 << 29), 1), 0, C(LONG_MIN), 2), 0, C(1), 1 << 30),
+    P(P(C(-1), 0, C(-2), 3), 0, C(-5), 1, P(P(C(-1), 2), 1, C(-7), 4), 3, C(LONG_MAX), 64),
+  };
+  size_t n = sizeof(polys) / sizeof(polys[0]);
+  DistPoly dist[sizeof(polys) / sizeof(polys[0])];
+  for (size_t i = 0; i < n; ++i) {
+    res &= DistFromPoly(&polys[i], &dist[i]);
+    Poly back = DistToPoly(&dist[i]);
+    res &= PolyIsEq(&back, &polys[i]);
+    PolyDestroy(&back);
+    res &= DistDeg(&dist[i]) == PolyDeg(&polys[i]);
+    for (size_t var = 0; var <= 4; ++var)
+      res &= DistDegBy(&dist[i], var) == PolyDegBy(&polys[i], var);
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      DistPoly sum;
+      res &= DistAdd(&dist[i], &dist[j], &sum);
+      Poly back = DistToPoly(&sum);
+      Poly expected = PolyAdd(&polys[i], &polys[j]);
+      res &= PolyIsEq(&back, &expected);
+      PolyDestroy(&back);
+      PolyDestroy(&expected);
+      DistDestroy(&sum);
+    }
+  }
+
+  Poly deep = P(P(P(P(P(C(1), INT_MAX), 1), 1), 1), 1);
+  DistPoly too_deep;
+  res &= !DistFromPoly(&deep, &too_deep);
+  DistDestroy(&too_deep);
+  PolyDestroy(&deep);
+
+  for (size_t i = 0; i < n; ++i) {
+    DistDestroy(&dist[i]);
+    PolyDestroy(&polys[i]);
+  }
+  return res;
+}
+
+/**
+ * Sprawdza sortowanie i scalanie jednomianów w PolyAddMonos dla tablic
+ * nieposortowanych, posortowanych, odwróconych i z wykładnikami bliskimi INT_MAX.
+ */
+static bool AddMonosOrderTest(void) {
+  bool res = true;
+  const size_t n = 300;
+  Mono *monos = malloc(3 * n * sizeof(Mono));
+  assert(monos != NULL);
+  for (int order = 0; order < 3; ++order) {
+    Poly expected = PolyZero();
+    for (size_t i = 0; i < 3 * n; ++i) {
+      size_t k = order == 0 ? (i * 7919) % (3 * n) : order == 1 ? i : 3 * n - 1 - i;
+      //Wykładniki bliskie INT_MAX występują parami, a część par się znosi.
+      poly_exp_t exp = k % 3 == 0 ? INT_MAX - (poly_exp_t) (k / 6) : (poly_exp_t) (k * 4099 % 100003);
+      poly_coeff_t coeff = k % 6 == 0 ? -1 : k % 12 == 3 ? 1 : (poly_coeff_t) (k % 5) + 1;
+      monos[i] = M(C(coeff), exp);
+      Poly single = P(C(coeff), exp);
+      Poly temp = PolyAdd(&expected, &single);
+      PolyDestroy(&expected);
+      PolyDestroy(&single);
+      expected = temp;
+    }
+    Poly p = PolyAddMonos(3 * n, monos);
+    res &= PolyIsEq(&p, &expected);
+    for (size_t i = 1; !PolyIsCoeff(&p) && i < p.size; ++i)
+      res &= p.arr[i - 1].exp < p.arr[i].exp;
+    PolyDestroy(&p);
+    PolyDestroy(&expected);
+  }
+
+  Mono cancel[] = {M(C(5), 7), M(C(3), 0), M(C(-5), 7), M(C(-3), 0)};
+  Poly zero = PolyAddMonos(4, cancel);
+  res &= PolyIsZero(&zero);
+  free(monos);
+  return res;
+}
+
+/**
+ * Sprawdza leniwe wyliczanie wyrażeń: zgodność z wyliczaniem od razu,
+ * współdzielenie węzłów, spłaszczanie sum i zwalnianie niewyliczonych węzłów.
+ */
+static bool LazyTest(void) {
+  bool res = true;
+  Poly p = P(P(C(1), 0, C(-2), 3), 0, C(5), 1);
+  Poly q = P(C(3), 1, C(LONG_MAX), 4);
+  Poly r = P(P(C(7), 2), 1);
+
+  //(p + q) * -(q - r) - (p + q)
+  LazyNode *sum = LazyBinary(LAZY_ADD, LazyFromPoly(PolyClone(&p)), LazyFromPoly(PolyClone(&q)));
+  LazyNode *diff = LazyBinary(LAZY_SUB, LazyFromPoly(PolyClone(&q)), LazyFromPoly(PolyClone(&r)));
+  LazyNode *prod = LazyBinary(LAZY_MUL, LazyShare(sum), LazyNeg(diff));
+  LazyNode *expr = LazyBinary(LAZY_ADD, prod, LazyNeg(sum));
+
+  Poly eager_sum = PolyAdd(&p, &q);
+  Poly eager_diff = PolySub(&q, &r);
+  Poly eager_neg = PolyNeg(&eager_diff);
+  Poly eager_prod = PolyMul(&eager_sum, &eager_neg);
+  Poly expected = PolySub(&eager_prod, &eager_sum);
+  res &= PolyIsEq(LazyForce(expr), &expected);
+  Poly taken = LazyTake(expr);
+  res &= PolyIsEq(&taken, &expected);
+  PolyDestroy(&taken);
+
+  //Długi łańcuch sum, częściowo z powtarzającym się składnikiem, i negacji.
+  LazyNode *shared = LazyFromPoly(PolyClone(&q));
+  LazyNode *chain = LazyFromPoly(PolyZero());
+  Poly eager_chain = PolyZero();
+  for (poly_exp_t i = 0; i < 100000; ++i) {
+    Poly term = P(C(i % 7 + 1), i % 1000);
+    LazyNode *node = i % 100 == 0 ? LazyShare(shared) : LazyFromPoly(PolyClone(&term));
+    chain = LazyBinary(i % 3 == 0 ? LAZY_SUB : LAZY_ADD, node, chain);
+    if (i % 5 == 0)
+      chain = LazyNeg(chain);
+    Poly added = i % 100 == 0 ? PolyClone(&q) : PolyClone(&term);
+    Poly temp = i % 3 == 0 ? PolySubOwn(&added, &eager_chain) : PolyAddOwn(&added, &eager_chain);
+    eager_chain = temp;
+    if (i % 5 == 0)
+      PolyNegInPlace(&eager_chain);
+    PolyDestroy(&term);
+  }
+  LazyNode *copy = LazyShare(chain);
+  res &= PolyIsEq(LazyForce(chain), &eager_chain);
+  res &= PolyIsEq(LazyForce(copy), &eager_chain);
+  LazyRelease(chain);
+  LazyRelease(copy);
+  LazyRelease(shared);
+  PolyDestroy(&eager_chain);
+
+  //Niewyliczone wyrażenie jest zwalniane bez liczenia.
+  LazyNode *unused = LazyFromPoly(PolyClone(&r));
+  for (int i = 0; i < 100000; ++i)
+    unused = LazyBinary(LAZY_MUL, unused, LazyFromPoly(PolyClone(&r)));
+  LazyRelease(unused);
+
+  PolyDestroy(&eager_sum);
+  PolyDestroy(&eager_diff);
+  PolyDestroy(&eager_neg);
+  PolyDestroy(&eager_prod);
+  PolyDestroy(&expected);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  PolyDestroy(&r);
+  return res;
+}
+
+/**
+ * Sprawdza sumowanie wielu wielomianów naraz: zgodność z dodawaniem parami,
+ * znoszenie się składników, stałe i niezmienianie wejścia współdzielonego z wynikiem.
+ */
+static bool SumManyTest(void) {
+  bool res = true;
+  const size_t n = 50;
+  Poly *ps = malloc(n * sizeof(Poly));
+  assert(ps != NULL);
+  Poly expected = PolyZero();
+  for (size_t i = 0; i < n; ++i) {
+    poly_coeff_t c = (poly_coeff_t) (i % 8) - 4;
+    c += c >= 0;
+    if (i % 10 == 0)
+      ps[i] = C((poly_coeff_t) ((unsigned long) c + LONG_MAX));
+    else
+      ps[i] = P(C(c), (poly_exp_t) (i % 4), P(C(1), 0, C(c), 2), (poly_exp_t) (i % 7 + 4));
+    Poly temp = PolyAdd(&expected, &ps[i]);
+    PolyDestroy(&expected);
+    expected = temp;
+  }
+  Poly sum = PolySumMany(n, ps);
+  res &= PolyIsEq(&sum, &expected);
+  PolyDestroy(&sum);
+
+  //Wynik współdzieli tablice z wejściem, które nie może się zmienić.
+  Poly kept = PolyClone(&ps[1]);
+  Poly *copies = malloc(n * sizeof(Poly));
+  assert(copies != NULL);
+  for (size_t i = 0; i < n; ++i)
+    copies[i] = PolyClone(&ps[i]);
+  sum = PolySumManyOwn(n, copies);
+  res &= PolyIsEq(&sum, &expected);
+  res &= PolyIsEq(&ps[1], &kept);
+  PolyDestroy(&sum);
+  PolyDestroy(&kept);
+
+  //Każdy składnik ma swoją negację, więc suma jest zerowa.
+  for (size_t i = 0; i < n; ++i)
+    copies[i] = i % 2 == 0 ? PolyClone(&ps[i / 2]) : PolyNeg(&ps[i / 2]);
+  sum = PolySumManyOwn(n, copies);
+  res &= PolyIsZero(&sum);
+
+  Poly constants[] = {C(3), C(-5), P(C(2), 0), C(0)};
+  sum = PolySumMany(4, constants);
+  res &= PolyIsCoeff(&sum) && sum.coeff == 0;
+  sum = PolySumMany(0, NULL);
+  res &= PolyIsZero(&sum);
+
+  for (size_t i = 0; i < n; ++i)
+    PolyDestroy(&ps[i]);
+  PolyDestroy(&constants[2]);
+  PolyDestroy(&expected);
+  free(copies);
+  free(ps);
+  return res;
+}
+
+/**
+ * Sprawdza wczytywanie wierszy z pliku, z odwzorowaniem w pamięci i bez:
+ * wiersze ze znakiem '\0', wiersz dłuższy niż blok wczytywania
+ * i ostatni wiersz bez znaku nowej linii.
+ */
+static bool ReaderTest(void) {
+  bool res = true;
+  const size_t long_length = 3 << 20;
+  FILE *f = tmpfile();
+  assert(f != NULL);
+  fputs("#skip\n", f);
+  fwrite("AB\0C\n", 1, 5, f);
+  for (size_t i = 0; i < long_length; ++i)
+    fputc('0' + (int) (i % 10), f);
+  fputs("\n\nlast", f);
+  fflush(f);
+
+  for (int map = 0; map < 2; ++map) {
+    rewind(f);
+    Reader r;
+    ReaderLine line;
+    ReaderOpen(&r, fileno(f), map);
+    res &= ReaderNext(&r, &line) && line.length == 6 && !line.has_nul && strcmp(line.text, "#skip\n") == 0;
+    res &= ReaderNext(&r, &line) && line.length == 5 && line.has_nul && memcmp(line.text, "AB\0C\n", 6) == 0;
+    res &= ReaderNext(&r, &line) && line.length == long_length + 1 && !line.has_nul;
+    res &= line.text[long_length - 1] == (char) ('0' + (long_length - 1) % 10) && line.text[long_length + 1] == '\0';
+    res &= ReaderNext(&r, &line) && line.length == 1 && strcmp(line.text, "\n") == 0;
+    res &= ReaderNext(&r, &line) && line.length == 4 && strcmp(line.text, "last") == 0;
+    res &= !ReaderNext(&r, &line);
+    ReaderClose(&r);
+  }
+  fclose(f);
+  return res;
+}
+
+/**
+ * Tworzy wielomian dwóch zmiennych o zadanej liczbie jednomianów.
+ * Jednomian @p i ma wykładnik @p step * @p i + @p seed % @p step, a jego
+ * współczynnik ma dwa jednomiany o współczynnikach branych cyklicznie z jednej
+ * z dwóch tablic: liczb, których sumy i iloczyny się przepełniają, albo liczb
+ * bliskich przepełnienia przeplatanych małymi liczbami.
+ * @param[in] n : liczba jednomianów
+ * @param[in] seed : ziarno wykładników i współczynników
+ * @param[in] step : odstęp między wykładnikami kolejnych jednomianów
+ * @param[in] near_max : czy brać współczynniki bliskie przepełnienia
+ * @return wielomian
+ */
+static Poly CyclicFactor(size_t n, size_t seed, size_t step, bool near_max) {
+  static const poly_coeff_t wrapping[] = {LONG_MIN, 1L << 62, -1, LONG_MAX, 3, -(1L << 40)};
+  static const poly_coeff_t large[] = {LONG_MAX, 1, LONG_MAX - 5, 7, LONG_MAX - 12, 11, LONG_MAX - 3};
+  const poly_coeff_t *coeffs = near_max ? large : wrapping;
+  const size_t count = near_max ? sizeof(large) / sizeof(large[0]) : sizeof(wrapping) / sizeof(wrapping[0]);
+  Mono *monos = malloc(n * sizeof(Mono));
+  assert(monos != NULL);
+  for (size_t i = 0; i < n; ++i) {
+    size_t k = i * 31 + seed;
+    monos[i] = M(P(C(coeffs[k % count]), (poly_exp_t) (k % 4),
+                   C(coeffs[(k + 1) % count]), (poly_exp_t) (k % 3 + 4)),
+                 (poly_exp_t) (step * i + seed % step));
+  }
+  return PolyOwnMonos(n, monos);
+}
+
+/**
+ * Sprawdza, czy mnożenie podstawieniem Kroneckera z transformatą
+ * teorioliczbową daje ten sam wynik co scalanie kopcem, także przy
+ * przepełnieniach współczynników i czynnikach różnej długości.
+ */
+static bool MulNttTest(void) {
+  bool res = true;
+  const size_t lengths[][2] = {{1, 1}, {5, 40}, {37, 3}, {64, 64}};
+  for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+    Poly p = CyclicFactor(lengths[i][0], i, 2, false);
+    Poly q = CyclicFactor(lengths[i][1], i + 7, 2, false);
+
+    MulSetMode(MUL_SPARSE);
+    Poly expected = PolyMul(&p, &q);
+    MulSetMode(MUL_DENSE);
+    MulSetNttCutoff(1);
+    Poly got = PolyMul(&p, &q);
+    res &= PolyIsEq(&got, &expected);
+    MulSetNttCutoff(NTT_DEFAULT_CUTOFF);
+    MulSetMode(MUL_AUTO);
+
+    PolyDestroy(&got);
+    PolyDestroy(&expected);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+  }
+  return res;
+}
+
+/**
+ * Tworzy wielomian jednej zmiennej o zadanej liczbie jednomianów
+ * o kolejnych wykładnikach i współczynnikach, których iloczyny się przepełniają.
+ * @param[in] n : liczba jednomianów
+ * @param[in] seed : ziarno współczynników
+ * @return wielomian
+ */
+static Poly WrappingLeaf(size_t n, size_t seed) {
+  static const poly_coeff_t coeffs[] = {LONG_MIN, -1, LONG_MAX, 1L << 62, 5, -(1L << 33)};
+  Mono *monos = malloc(n * sizeof(Mono));
+  assert(monos != NULL);
+  for (size_t i = 0; i < n; ++i)
+    monos[i] = M(C(coeffs[(i + seed) % (sizeof(coeffs) / sizeof(coeffs[0]))]), (poly_exp_t) i);
+  return PolyOwnMonos(n, monos);
+}
+
+/**
+ * Sprawdza, czy scalanie kopcem i podstawienie Kroneckera dają ten sam wynik
+ * na wielomianach liściowych, zagnieżdżonych i z wykładnikiem INT_MAX,
+ * ze współczynnikami LONG_MIN i LONG_MAX oraz przy czynnikach różnej długości.
+ * Podstawienie Kroneckera mnoży tablice algorytmem Karatsuby przy różnych
+ * progach, a potem szybką transformatą teorioliczbową.
+ */
+static bool MulKernelsTest(void) {
+  bool res = true;
+  const size_t lengths[][2] = {{1, 1}, {3, 50}, {40, 40}, {70, 9}};
+  const size_t karatsuba_cutoffs[] = {2, KARATSUBA_DEFAULT_CUTOFF};
+  const size_t ntt_cutoffs[] = {SIZE_MAX, 1};
+  for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+    Poly factors[][2] = {
+      {WrappingLeaf(lengths[i][0], i), WrappingLeaf(lengths[i][1], i + 3)},
+      {CyclicFactor(lengths[i][0], i, 2, false), CyclicFactor(lengths[i][1], i + 5, 3, false)},
+      {P(C(LONG_MIN), 0, CyclicFactor(lengths[i][0], i, 1, true), 2, C(-1), INT_MAX),
+       CyclicFactor(lengths[i][1], i + 1, 2, false)},
+    };
+    for (size_t f = 0; f < sizeof(factors) / sizeof(factors[0]); ++f) {
+      MulSetMode(MUL_SPARSE);
+      Poly expected = PolyMul(&factors[f][0], &factors[f][1]);
+      MulSetMode(MUL_DENSE);
+      for (size_t n = 0; n < sizeof(ntt_cutoffs) / sizeof(ntt_cutoffs[0]); ++n) {
+        MulSetNttCutoff(ntt_cutoffs[n]);
+        for (size_t k = 0; k < sizeof(karatsuba_cutoffs) / sizeof(karatsuba_cutoffs[0]); ++k) {
+          MulSetKaratsubaCutoff(karatsuba_cutoffs[k]);
+          Poly got = PolyMul(&factors[f][0], &factors[f][1]);
+          res &= PolyIsEq(&got, &expected);
+          PolyDestroy(&got);
+        }
+      }
+      MulSetKaratsubaCutoff(KARATSUBA_DEFAULT_CUTOFF);
+      MulSetNttCutoff(NTT_DEFAULT_CUTOFF);
+      MulSetMode(MUL_AUTO);
+      PolyDestroy(&expected);
+      PolyDestroy(&factors[f][0]);
+      PolyDestroy(&factors[f][1]);
+    }
+  }
+  return res;
+}
+
+/**
+ * Sprawdza, czy mnożenie podzielone między wątki daje ten sam wynik
+ * co mnożenie w jednym wątku, także przy zagnieżdżonych zadaniach.
+ */
+static bool MulParallelTest(void) {
+  bool res = true;
+  Poly p = CyclicFactor(90, 1, 3, true);
+  Poly q = CyclicFactor(70, 2, 3, true);
+  Poly expected = PolyMul(&p, &q);
+  Poly expected_square = PolyMul(&expected, &expected);
+
+  PoolSetThreads(4);
+  MulSetParallelCutoff(16);
+  Poly split = PolyMul(&p, &q);
+  res &= PolyIsEq(&split, &expected);
+  Poly direct = MulParallel(&p, &q);
+  res &= PolyIsEq(&direct, &expected);
+  //Wyniki wątków roboczych muszą się dać zwolnić w wątku głównym.
+  Poly square = PolyMul(&split, &split);
+  res &= PolyIsEq(&square, &expected_square);
+  MulSetParallelCutoff(PARALLEL_DEFAULT_CUTOFF);
+  PoolSetThreads(1);
+
+  PolyDestroy(&square);
+  PolyDestroy(&expected_square);
+  PolyDestroy(&split);
+  PolyDestroy(&direct);
+  PolyDestroy(&expected);
+  PolyDestroy(&p);
+  PolyDestroy(&q);
+  return res;
+}
+
+/**
+ * Sprawdza, czy złożenie podzielone między wątki daje ten sam wynik
+ * co złożenie w jednym wątku.
+ */
+static bool ComposeParallelTest(void) {
+  bool res = true;
+  Poly p = CyclicFactor(60, 3, 3, true);
+  Poly q[] = {P(C(1), 0, C(-1), 1, C(2), 3), P(P(C(3), 1), 0, C(LONG_MAX), 2)};
+  Poly expected = PolyCompose(&p, 2, q);
+  Poly partial = PolyCompose(&p, 1, q);
+
+  PoolSetThreads(4);
+  Poly split = PolyCompose(&p, 2, q);
+  res &= PolyIsEq(&split, &expected);
+  Poly split_partial = PolyCompose(&p, 1, q);
+  res &= PolyIsEq(&split_partial, &partial);
+  PoolSetThreads(1);
+
+  PolyDestroy(&split);
+  PolyDestroy(&split_partial);
+  PolyDestroy(&expected);
+  PolyDestroy(&partial);
+  PolyDestroy(&p);
+  PolyDestroy(&q[0]);
+  PolyDestroy(&q[1]);
+  return res;
+}
+
+/**
+ * Sprawdza, czy długi wiersz z wielomianem wczytany w wielu wątkach daje
+ * ten sam wielomian co wczytany w jednym wątku i czy wiersz pozostaje niezmieniony.
+ */
+static bool ParseParallelTest(void) {
+  bool res = true;
+  const size_t n = 20000;
+  const size_t capacity = 64 * n;
+  char *text = malloc(capacity);
+  assert(text != NULL);
+  size_t length = 0;
+  for (size_t i = 0; i < n; ++i) {
+    size_t k = i * 7919;
+    length += snprintf(text + length, capacity - length, "%s((%ld,%zu)+(-%zu,%zu),%zu)",
+                       i == 0 ? "" : "+", LONG_MAX - (long) (k % 13), k % 5, k % 11 + 1, k % 3 + 5,
+                       k % 4999);
+  }
+  length += snprintf(text + length, capacity - length, "\n");
+  char *copy = malloc(length + 1);
+  assert(copy != NULL);
+  memcpy(copy, text, length + 1);
+
+  Stack single = NewStack();
+  LineInterpreter(text, 1, length, false, &single);
+  PoolSetThreads(4);
+  Stack split = NewStack();
+  LineInterpreter(text, 1, length, false, &split);
+  PoolSetThreads(1);
+  res &= single.size == 1 && split.size == 1;
+  if (res) {
+    Poly expected = StackTop(&single);
+    Poly got = StackTop(&split);
+    res &= PolyIsEq(&expected, &got) && !PolyIsCoeff(&got) && got.size == 4999;
+  }
+  res &= memcmp(text, copy, length + 1) == 0;
+
+  StackDestroy(&single);
+  StackDestroy(&split);
+  free(copy);
+  free(text);
+  return res;
+}
+
+/**
+ * Sprawdza wczytywanie wielomianów bez rekurencji: bardzo głęboko
+ * zagnieżdżony wielomian i liczby na granicach zakresów.
+ */
+static bool ParseDeepTest(void) {
+  bool res = true;
+  const size_t depth = 1000000;
+  char *text = malloc(4 * depth + 2);
+  assert(text != NULL);
+  memset(text, '(', depth);
+  text[depth] = '7';
+  for (size_t i = 0; i < depth; ++i)
+    memcpy(text + depth + 1 + 3 * i, ",0)", 3);
+  text[4 * depth + 1] = '\0';
+
+  Stack s = NewStack();
+  LineInterpreter(text, 1, 4 * depth + 1, false, &s);
+  char bounds[] = "(-9223372036854775808,-0)+(0009223372036854775807,0002147483647)\n";
+  LineInterpreter(bounds, 2, strlen(bounds), false, &s);
+  res &= s.size == 2;
+  if (res) {
+    Poly expected = P(C(LONG_MIN), 0, C(LONG_MAX), INT_MAX);
+    Poly bounds_poly = StackTop(&s);
+    res &= PolyIsEq(&bounds_poly, &expected);
+    PolyDestroy(&expected);
+    StackDrop(&s);
+    Poly deep = StackTop(&s);
+    res &= PolyIsCoeff(&deep) && deep.coeff == 7;
+  }
+
+  StackDestroy(&s);
+  free(text);
+  return res;
+}
+
+/**
+ * Sprawdza wczytywanie długich liczb, także z zerami wiodącymi, w wielomianach
+ * i w argumentach poleceń AT, DEG_BY i COMPOSE.
+ */
+static bool ParseNumbersTest(void) {
+  bool res = true;
+  char poly[] = "(00000000000000000009223372036854775807,00000000002147483647)+"
+                "(-9223372036854775808,12345678)+(1234567890123456789,0)\n";
+  char at[] = "AT -9223372036854775807\n";
+  char deg_by[] = "DEG_BY 000000000000000000000000000000000000001\n";
+  char compose[] = "COMPOSE 00000000000000000000";
+
+  Stack s = NewStack();
+  LineInterpreter(poly, 1, strlen(poly), false, &s);
+  res &= s.size == 1;
+  if (res) {
+    Poly expected = P(C(1234567890123456789), 0, C(LONG_MIN), 12345678, C(LONG_MAX), INT_MAX);
+    Poly top = StackTop(&s);
+    res &= PolyIsEq(&top, &expected);
+
+    Poly value = PolyAt(&expected, -LONG_MAX);
+    LineInterpreter(at, 2, strlen(at), false, &s);
+    LineInterpreter(deg_by, 3, strlen(deg_by), false, &s);
+    LineInterpreter(compose, 4, strlen(compose), false, &s);
+    top = StackTop(&s);
+    res &= s.size == 1 && PolyIsEq(&top, &value);
+    PolyDestroy(&value);
+    PolyDestroy(&expected);
+  }
+
+  StackDestroy(&s);
+  return res;
+}
+
+/**
+ * Sprawdza, czy COMPOSE z parametrem większym niż rozmiar stosu, także
+ * największym możliwym przy pustym stosie, zgłasza niedobór elementów stosu.
+ */
+static bool ComposeUnderflowTest(void) {
+  bool res = true;
+  char push[] = "1\n";
+  char pop[] = "POP\n";
+  char compose_max[] = "COMPOSE 18446744073709551615\n";
+  char compose_one[] = "COMPOSE 1\n";
+
+  FILE *errors = tmpfile();
+  assert(errors != NULL);
+  fflush(stderr);
+  int saved = dup(fileno(stderr));
+  assert(saved >= 0);
+  dup2(fileno(errors), fileno(stderr));
+
+  Stack s = NewStack();
+  LineInterpreter(push, 1, strlen(push), false, &s);
+  LineInterpreter(pop, 2, strlen(pop), false, &s);
+  LineInterpreter(compose_max, 3, strlen(compose_max), false, &s);
+  LineInterpreter(push, 4, strlen(push), false, &s);
+  LineInterpreter(compose_one, 5, strlen(compose_one), false, &s);
+  res &= s.size == 1;
+  StackDestroy(&s);
+
+  fflush(stderr);
+  dup2(saved, fileno(stderr));
+  close(saved);
+  char buffer[128] = {0};
+  rewind(errors);
+  fread(buffer, 1, sizeof(buffer) - 1, errors);
+  fclose(errors);
+  res &= strcmp(buffer, "ERROR 3 STACK UNDERFLOW\nERROR 5 STACK UNDERFLOW\n") == 0;
+  return res;
+}
+
+/**
+ * Wykonuje w trybie aren powtarzany ciąg poleceń kalkulatora na stosie
+ * z jednym wielomianem i sprawdza, że pamięć aren stosu nie rośnie z liczbą
+ * powtórzeń, czyli że areny argumentów są zwalniane, a nie dołączane do wyniku.
+ * @param[in] start : wiersz z początkowym wielomianem
+ * @param[in] commands : wiersze wykonywane w każdym powtórzeniu
+ * @param[in] count : liczba wierszy w powtórzeniu
+ * @param[in] steps : liczba powtórzeń
+ * @return czy pamięć aren pozostała ograniczona
+ */
+static bool ArenaChainBounded(char *start, const char *const commands[], size_t count, size_t steps) {
+  bool res = true;
+  Stack s = NewStack();
+  s.use_arenas = true;
+  LineInterpreter(start, 1, strlen(start), false, &s);
+  size_t first = 0;
+  for (size_t i = 0; i < steps; i++) {
+    for (size_t c = 0; c < count; c++) {
+      char line[32];
+      size_t length = strlen(commands[c]);
+      assert(length < sizeof(line));
+      memcpy(line, commands[c], length + 1);
+      LineInterpreter(line, i + 2, length, false, &s);
+    }
+    size_t bytes = 0;
+    for (size_t j = 0; j < s.size; j++)
+      bytes += ArenaBytes(s.arenas[j]);
+    if (i == 0)
+      first = bytes;
+    res &= s.size == 1 && bytes <= 2 * first;
+  }
+  StackDestroy(&s);
+  return res;
+}
+
+/**
+ * Sprawdza, że w trybie aren pamięć stosu nie rośnie podczas długich łańcuchów
+ * operacji, zarówno budujących wynik od nowa, jak i działających w miejscu.
+ */
+static bool ArenaChainTest(void) {
+  bool res = true;
+  const size_t monos = 2000;
+  char *text = malloc(monos * 16 + 2);
+  assert(text != NULL);
+  size_t length = 0;
+  for (size_t i = 0; i < monos; i++)
+    length += sprintf(text + length, "%s(1,%zu)", i == 0 ? "" : "+", i);
+  text[length++] = '\n';
+  text[length] = '\0';
+  const char *const mul[] = {"(1,1)\n", "MUL\n"};
+  res &= ArenaChainBounded(text, mul, 2, 800);
+  free(text);
+
+  char start[] = "(1,1)+(1,2)\n";
+  const char *const add[] = {"(1,1)\n", "ADD\n"};
+  res &= ArenaChainBounded(start, add, 2, 5000);
+  const char *const sub[] = {"(1,2)\n", "SUB\n"};
+  res &= ArenaChainBounded(start, sub, 2, 5000);
+  const char *const neg[] = {"NEG\n"};
+  res &= ArenaChainBounded(start, neg, 1, 5000);
+  const char *const scale[] = {"-1\n", "MUL\n"};
+  res &= ArenaChainBounded(start, scale, 2, 5000);
+
+  char nested[] = "((1,1),1)+(1,2)\n";
+  const char *const at[] = {"AT 2\n", "((1,1),1)+(1,2)\n", "ADD\n"};
+  res &= ArenaChainBounded(nested, at, 3, 5000);
+  return res;
+}
+
+/**
+ * Sprawdza, czy podstawienie Kroneckera odrzuca wykładniki, które przepełniły
+ * się przy wcześniejszym mnożeniu, i daje wtedy ten sam wynik co scalanie kopcem.
+ */
+static bool MulDenseWrapTest(void) {
+  const MulMode modes[] = {MUL_SPARSE, MUL_DENSE};
+  Poly p = P(P(C(4), 5, C(20), 123), 3, C(12), INT_MAX);
+  Poly square[2], fourth[2];
+  for (size_t m = 0; m < 2; ++m) {
+    MulSetMode(modes[m]);
+    square[m] = PolyMul(&p, &p);
+    fourth[m] = PolyMul(&square[m], &square[m]);
+  }
+  MulSetMode(MUL_AUTO);
+
+  bool res = PolyIsEq(&square[0], &square[1]) && PolyIsEq(&fourth[0], &fourth[1]);
+  for (size_t m = 0; m < 2; ++m) {
+    PolyDestroy(&square[m]);
+    PolyDestroy(&fourth[m]);
+  }
+  PolyDestroy(&p);
+  return res;
+}
+
+/**
+ * Sprawdza, czy wyliczanie wartości zagnieżdżonego wielomianu z przepełnieniami
+ * kolejnymi wywołaniami PolyAt daje tę samą wartość co PolyEvalPoint.
+ */
+static bool AtWrapTest(void) {
+  bool res = true;
+  Poly p = P(P(C(LONG_MAX), 1, C(LONG_MIN), 4), 0, C(LONG_MAX), 3, P(C(-3), 0, C(LONG_MAX), 2), 7);
+  const poly_coeff_t points[][2] = {{LONG_MAX, LONG_MIN}, {LONG_MIN, 3}, {1L << 32, LONG_MAX}, {-1, -1}};
+  for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); ++i) {
+    Poly inner = PolyAt(&p, points[i][0]);
+    Poly value = PolyAt(&inner, points[i][1]);
+    res &= PolyIsCoeff(&value) && value.coeff == PolyEvalPoint(&p, 2, points[i]);
+    PolyDestroy(&inner);
+  }
+  PolyDestroy(&p);
+  return res;
+}
+
 /** GRUPY TESTÓW **/
 
 static bool SimpleNegGroup(void) {
@@ -4047,6 +5148,31 @@ static const test_list_t test_list[] = {
   TEST(MemoryThiefTest),
   TEST(MemoryFreeTest),
   TEST(MemoryGroup),
+  TEST(ArenaTest),
+  TEST(BlockPoolTest),
+  TEST(OwnTest),
+  TEST(SharingTest),
+  TEST(InternTest),
+  TEST(ComposeTest),
+  TEST(AtManyTest),
+  TEST(ProgramTest),
+  TEST(LeafTest),
+  TEST(DistTest),
+  TEST(AddMonosOrderTest),
+  TEST(LazyTest),
+  TEST(SumManyTest),
+  TEST(ReaderTest),
+  TEST(MulNttTest),
+  TEST(MulKernelsTest),
+  TEST(MulParallelTest),
+  TEST(ComposeParallelTest),
+  TEST(ParseParallelTest),
+  TEST(ParseDeepTest),
+  TEST(ParseNumbersTest),
+  TEST(ComposeUnderflowTest),
+  TEST(ArenaChainTest),
+  TEST(MulDenseWrapTest),
+  TEST(AtWrapTest),
 };
 
 int main(int argc, char *argv[]) {
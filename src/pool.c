@@ -0,0 +1,285 @@
+/** @file
+  Implementacja puli wątków z podkradaniem zadań.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+//To jest makro potrzebne do działania funkcji sysconf i sched_yield.
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "pool.h"
+#include "memory.h"
+
+/** Początkowa pojemność kolejki zadań. */
+#define DEQUE_INITIAL_CAPACITY 64
+
+/** Liczba nieudanych prób znalezienia zadania, po której PoolWait zasypia. */
+#define POOL_WAIT_SPINS 64
+
+/**
+ * To jest struktura opisująca zlecone zadanie.
+ */
+typedef struct Task {
+    void (*run)(void *arg); ///< funkcja wykonująca zadanie
+    void *arg; ///< argument funkcji
+    TaskGroup *group; ///< grupa zadania
+} Task;
+
+/**
+ * To jest struktura przechowująca kolejkę zadań jednego wątku w tablicy cyklicznej.
+ * Właściciel wstawia i zdejmuje zadania z końca, a inne wątki podkradają z początku.
+ */
+typedef struct Deque {
+    pthread_mutex_t lock; ///< blokada kolejki
+    Task *tasks; ///< tablica zadań
+    size_t head; ///< indeks pierwszego zadania
+    size_t size; ///< liczba zadań
+    size_t capacity; ///< pojemność tablicy, potęga dwójki
+} Deque;
+
+/** Liczba wątków wykonujących zadania, razem z wątkiem zlecającym. */
+static size_t thread_count = 1;
+
+/** Kolejki zadań: wspólna kolejka wątków spoza puli, a za nią kolejki wątków roboczych. */
+static Deque *deques = NULL;
+
+/** Wątki robocze. */
+static pthread_t *workers = NULL;
+
+/** Liczba zadań czekających we wszystkich kolejkach. */
+static atomic_size_t queued;
+
+/** Blokada, pod którą bezczynne wątki robocze czekają na zadania. */
+static pthread_mutex_t sleep_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** Zmienna warunkowa budząca bezczynne wątki robocze. */
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+
+/** Zmienna warunkowa budząca wątki czekające w PoolWait. */
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+
+/** Liczba wątków śpiących w PoolWait, chroniona blokadą sleep_lock. */
+static size_t waiting = 0;
+
+/** Czy wątki robocze mają się zakończyć. */
+static bool stopping = false;
+
+/** Indeks kolejki bieżącego wątku, 0 dla wątków spoza puli. */
+static _Thread_local size_t own_deque = 0;
+
+/** Liczba zadań wykonywanych właśnie przez bieżący wątek, jedno w drugim. */
+static _Thread_local size_t running = 0;
+
+void PoolSetThreads(size_t threads) {
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t) online : 1;
+    }
+    PoolShutdown();
+    thread_count = threads;
+}
+
+size_t PoolThreads(void) {
+    return thread_count;
+}
+
+bool PoolInTask(void) {
+    return running > 0;
+}
+
+void TaskGroupInit(TaskGroup *group) {
+    atomic_init(&group->pending, 0);
+}
+
+/**
+ * Wstawia zadanie na koniec kolejki, w razie potrzeby ją powiększając.
+ * @param[in,out] deque : kolejka
+ * @param[in] task : zadanie
+ */
+static void DequePush(Deque *deque, Task task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->size == deque->capacity) {
+        Task *tasks = (Task *) SafeMalloc(2 * deque->capacity * sizeof(Task));
+        for (size_t i = 0; i < deque->size; i++)
+            tasks[i] = deque->tasks[(deque->head + i) & (deque->capacity - 1)];
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->head = 0;
+        deque->capacity *= 2;
+    }
+    deque->tasks[(deque->head + deque->size) & (deque->capacity - 1)] = task;
+    deque->size++;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+/**
+ * Zdejmuje zadanie z kolejki.
+ * @param[in,out] deque : kolejka
+ * @param[in] back : czy zdjąć zadanie z końca (właściciel), czy z początku (podkradanie)
+ * @param[out] task : zdjęte zadanie
+ * @return czy kolejka miała zadanie
+ */
+static bool DequeTake(Deque *deque, bool back, Task *task) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->size > 0;
+    if (found) {
+        deque->size--;
+        if (back) {
+            *task = deque->tasks[(deque->head + deque->size) & (deque->capacity - 1)];
+        } else {
+            *task = deque->tasks[deque->head];
+            deque->head = (deque->head + 1) & (deque->capacity - 1);
+        }
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+/**
+ * Szuka zadania: najpierw najmłodszego we własnej kolejce, potem
+ * najstarszego w kolejkach innych wątków.
+ * @param[out] task : znalezione zadanie
+ * @return czy znaleziono zadanie
+ */
+static bool FindTask(Task *task) {
+    if (atomic_load_explicit(&queued, memory_order_acquire) == 0)
+        return false;
+    bool found = DequeTake(&deques[own_deque], true, task);
+    for (size_t i = 1; !found && i < thread_count; i++)
+        found = DequeTake(&deques[(own_deque + i) % thread_count], false, task);
+    if (found)
+        atomic_fetch_sub_explicit(&queued, 1, memory_order_relaxed);
+    return found;
+}
+
+/**
+ * Wykonuje zadanie i oznacza je jako zakończone w jego grupie. Po zakończeniu
+ * ostatniego zadania grupy budzi wątki czekające w PoolWait.
+ * @param[in] task : zadanie
+ */
+static void RunTask(const Task *task) {
+    running++;
+    task->run(task->arg);
+    running--;
+    //Po zmniejszeniu licznika grupa może już nie istnieć, więc dalej jej nie dotykamy.
+    if (atomic_fetch_sub_explicit(&task->group->pending, 1, memory_order_release) == 1 && thread_count > 1) {
+        pthread_mutex_lock(&sleep_lock);
+        pthread_cond_broadcast(&done);
+        pthread_mutex_unlock(&sleep_lock);
+    }
+}
+
+/**
+ * Pętla wątku roboczego: wykonuje zadania, a gdy ich nie ma, czeka na nie.
+ * @param[in] arg : indeks kolejki wątku
+ * @return NULL
+ */
+static void *WorkerMain(void *arg) {
+    own_deque = (size_t) arg;
+    while (true) {
+        Task task;
+        if (FindTask(&task)) {
+            RunTask(&task);
+            continue;
+        }
+        pthread_mutex_lock(&sleep_lock);
+        while (!stopping && atomic_load(&queued) == 0)
+            pthread_cond_wait(&wake, &sleep_lock);
+        bool stop = stopping;
+        pthread_mutex_unlock(&sleep_lock);
+        if (stop)
+            break;
+    }
+    //Pula małych bloków jest osobna dla każdego wątku i znika razem z nim.
+    BlockPoolRelease();
+    return NULL;
+}
+
+/**
+ * Tworzy kolejki i wątki robocze, jeśli jeszcze ich nie ma.
+ */
+static void PoolStart(void) {
+    if (deques != NULL)
+        return;
+    atomic_init(&queued, 0);
+    stopping = false;
+    deques = (Deque *) SafeMalloc(thread_count * sizeof(Deque));
+    for (size_t i = 0; i < thread_count; i++) {
+        pthread_mutex_init(&deques[i].lock, NULL);
+        deques[i].tasks = (Task *) SafeMalloc(DEQUE_INITIAL_CAPACITY * sizeof(Task));
+        deques[i].head = deques[i].size = 0;
+        deques[i].capacity = DEQUE_INITIAL_CAPACITY;
+    }
+    workers = (pthread_t *) SafeMalloc(thread_count * sizeof(pthread_t));
+    for (size_t i = 1; i < thread_count; i++) {
+        if (pthread_create(&workers[i], NULL, WorkerMain, (void *) i) != 0)
+            exit(1);
+    }
+}
+
+void PoolSpawn(TaskGroup *group, void (*run)(void *arg), void *arg) {
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+    Task task = {.run = run, .arg = arg, .group = group};
+    if (thread_count == 1) {
+        RunTask(&task);
+        return;
+    }
+
+    //Licznik zadań rośnie przed wstawieniem zadania, więc nigdy nie jest mniejszy
+    //od liczby zadań w kolejkach i zasypiający wątek nie przegapi zadania.
+    PoolStart();
+    atomic_fetch_add_explicit(&queued, 1, memory_order_relaxed);
+    DequePush(&deques[own_deque], task);
+    pthread_mutex_lock(&sleep_lock);
+    pthread_cond_signal(&wake);
+    if (waiting > 0)
+        pthread_cond_signal(&done);
+    pthread_mutex_unlock(&sleep_lock);
+}
+
+void PoolWait(TaskGroup *group) {
+    size_t idle = 0;
+    while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0) {
+        Task task;
+        if (FindTask(&task)) {
+            RunTask(&task);
+            idle = 0;
+        } else if (idle < POOL_WAIT_SPINS) {
+            idle++;
+            sched_yield();
+        } else {
+            //Zadania grupy wykonują inne wątki; śpimy do końca grupy albo do nowego zadania.
+            pthread_mutex_lock(&sleep_lock);
+            waiting++;
+            while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0 && atomic_load(&queued) == 0)
+                pthread_cond_wait(&done, &sleep_lock);
+            waiting--;
+            pthread_mutex_unlock(&sleep_lock);
+        }
+    }
+}
+
+void PoolShutdown(void) {
+    if (deques == NULL)
+        return;
+    pthread_mutex_lock(&sleep_lock);
+    stopping = true;
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&sleep_lock);
+    for (size_t i = 1; i < thread_count; i++)
+        pthread_join(workers[i], NULL);
+    for (size_t i = 0; i < thread_count; i++) {
+        pthread_mutex_destroy(&deques[i].lock);
+        free(deques[i].tasks);
+    }
+    free(deques);
+    free(workers);
+    deques = NULL;
+    workers = NULL;
+}
@@ -0,0 +1,78 @@
+/** @file
+  Interfejs puli wątków z podkradaniem zadań.
+
+  Każdy wątek roboczy ma własną kolejkę zadań: zadania zlecone przez wątek
+  trafiają na koniec jego kolejki i są z niego zdejmowane, a bezczynne wątki
+  podkradają zadania z początku kolejek innych wątków. Wątki spoza puli
+  zlecają zadania do wspólnej kolejki. Wątek czekający na grupę zadań sam
+  wykonuje zadania, więc zadania mogą zlecać i czekać na kolejne zadania.
+
+  Wątki robocze są tworzone przy pierwszym zleceniu zadania. Przy jednym
+  wątku (ustawienie domyślne) zadania są wykonywane od razu przez zlecającego.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * To jest struktura przechowująca grupę zadań, na której zakończenie można czekać.
+ */
+typedef struct TaskGroup {
+    atomic_size_t pending; ///< liczba niezakończonych zadań grupy
+} TaskGroup;
+
+/**
+ * Ustawia liczbę wątków wykonujących zadania, razem z wątkiem zlecającym.
+ * Kończy działające wątki robocze. Nie wolno jej wołać w czasie wykonywania zadań.
+ * @param[in] threads : liczba wątków, 0 oznacza liczbę dostępnych procesorów
+ */
+void PoolSetThreads(size_t threads);
+
+/**
+ * Zwraca liczbę wątków wykonujących zadania.
+ * @return liczba wątków
+ */
+size_t PoolThreads(void);
+
+/**
+ * Sprawdza, czy bieżący wątek wykonuje właśnie zadanie z puli.
+ * @return czy wątek jest w trakcie zadania
+ */
+bool PoolInTask(void);
+
+/**
+ * Inicjuje pustą grupę zadań.
+ * @param[out] group : grupa zadań
+ */
+void TaskGroupInit(TaskGroup *group);
+
+/**
+ * Zleca wykonanie zadania w ramach grupy.
+ * @param[in,out] group : grupa zadań
+ * @param[in] run : funkcja wykonująca zadanie
+ * @param[in] arg : argument funkcji
+ */
+void PoolSpawn(TaskGroup *group, void (*run)(void *arg), void *arg);
+
+/**
+ * Czeka na zakończenie wszystkich zadań grupy, wykonując w tym czasie zadania z puli.
+ * Gdy żadnego zadania nie da się podkraść, zasypia zamiast zajmować procesor.
+ * @param[in,out] group : grupa zadań
+ */
+void PoolWait(TaskGroup *group);
+
+/**
+ * Kończy wątki robocze i zwalnia pamięć puli. Liczba wątków pozostaje
+ * ustawiona, a wątki zostaną utworzone ponownie przy następnym zleceniu.
+ */
+void PoolShutdown(void);
+
+#endif //POOL_H
@@ -0,0 +1,265 @@
+/** @file
+  Implementacja programów wyliczających wartości wielomianów.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#include <stdlib.h>
+#include "program.h"
+#include "memory.h"
+
+/** Liczba wartości, które wykonanie programu trzyma na stosie wywołań zamiast na stercie. */
+#define PROGRAM_LOCAL_SLOTS 64
+
+/**
+ * To jest typ wyznaczający rodzaj instrukcji programu.
+ */
+typedef enum Opcode {
+    OP_PUSH, ///< wstawia stałą na stos
+    OP_ADD_CONST, ///< dodaje stałą do wartości na szczycie stosu
+    OP_ADD, ///< zdejmuje wartość ze stosu i dodaje ją do wartości na nowym szczycie
+    OP_MUL_POWER ///< mnoży wartość na szczycie stosu przez potęgę zmiennej
+} Opcode;
+
+/**
+ * To jest struktura przechowująca instrukcję programu.
+ */
+typedef struct Instruction {
+    Opcode op; ///< rodzaj instrukcji
+    unsigned long arg; ///< stała albo indeks potęgi
+} Instruction;
+
+/**
+ * To jest struktura opisująca potęgę zmiennej wyliczaną na początku wykonania.
+ * Potęgi są posortowane względem zmiennej i wykładnika, więc każdą potęgę
+ * oprócz pierwszej potęgi danej zmiennej liczymy z poprzedniej.
+ */
+typedef struct PowerStep {
+    size_t var; ///< indeks zmiennej
+    poly_exp_t exp; ///< wykładnik
+    poly_exp_t step; ///< wykładnik, do którego podnosimy zmienną w tym kroku
+    bool chained; ///< czy wynik kroku mnożymy przez poprzednią potęgę
+} PowerStep;
+
+struct PolyProgram {
+    Instruction *code; ///< instrukcje
+    size_t length; ///< liczba instrukcji
+    PowerStep *powers; ///< potęgi zmiennych
+    size_t power_count; ///< liczba potęg zmiennych
+    size_t depth; ///< największa wysokość stosu
+};
+
+/**
+ * To jest struktura przechowująca stan tłumaczenia wielomianu na program.
+ */
+typedef struct Compiler {
+    size_t nvars; ///< liczba zmiennych
+    Instruction *code; ///< instrukcje
+    size_t length; ///< liczba instrukcji
+    size_t capacity; ///< pojemność tablicy instrukcji
+    PowerStep *powers; ///< żądane potęgi, w kolejności żądań i z powtórzeniami
+    size_t power_count; ///< liczba żądanych potęg
+    size_t power_capacity; ///< pojemność tablicy żądanych potęg
+    size_t depth; ///< bieżąca wysokość stosu
+    size_t max_depth; ///< największa wysokość stosu
+} Compiler;
+
+/**
+ * Dopisuje instrukcję do programu.
+ * @param[in,out] c : stan tłumaczenia
+ * @param[in] op : rodzaj instrukcji
+ * @param[in] arg : argument instrukcji
+ */
+static void Emit(Compiler *c, Opcode op, unsigned long arg) {
+    if (c->length == c->capacity) {
+        c->capacity = c->capacity == 0 ? 16 : 2 * c->capacity;
+        c->code = (Instruction *) SafeRealloc(c->code, c->capacity * sizeof(Instruction));
+    }
+    c->code[c->length++] = (Instruction) {.op = op, .arg = arg};
+    if (op == OP_PUSH && ++c->depth > c->max_depth)
+        c->max_depth = c->depth;
+    else if (op == OP_ADD)
+        c->depth--;
+}
+
+/**
+ * Zgłasza potrzebę wyliczenia potęgi zmiennej.
+ * @param[in,out] c : stan tłumaczenia
+ * @param[in] var : indeks zmiennej
+ * @param[in] exp : wykładnik
+ * @return tymczasowy indeks potęgi
+ */
+static unsigned long RequestPower(Compiler *c, size_t var, poly_exp_t exp) {
+    if (c->power_count == c->power_capacity) {
+        c->power_capacity = c->power_capacity == 0 ? 16 : 2 * c->power_capacity;
+        c->powers = (PowerStep *) SafeRealloc(c->powers, c->power_capacity * sizeof(PowerStep));
+    }
+    c->powers[c->power_count] = (PowerStep) {.var = var, .exp = exp, .step = 0, .chained = false};
+    return c->power_count++;
+}
+
+/**
+ * Tłumaczy wielomian zmiennych od @p level wzwyż na instrukcje, które
+ * wstawiają jego wartość na stos.
+ * @param[in,out] c : stan tłumaczenia
+ * @param[in] p : wielomian
+ * @param[in] level : indeks zmiennej głównej wielomianu @p p
+ */
+static void CompileAt(Compiler *c, const Poly *p, size_t level) {
+    if (PolyIsCoeff(p)) {
+        Emit(c, OP_PUSH, (unsigned long) p->coeff);
+        return;
+    }
+    if (level >= c->nvars) {
+        if (p->arr[0].exp == 0)
+            CompileAt(c, &p->arr[0].p, level + 1);
+        else
+            Emit(c, OP_PUSH, 0);
+        return;
+    }
+
+    CompileAt(c, &p->arr[p->size - 1].p, level + 1);
+    for (size_t i = p->size - 1; i > 0; i--) {
+        Emit(c, OP_MUL_POWER, RequestPower(c, level, p->arr[i].exp - p->arr[i - 1].exp));
+        const Poly *coeff = &p->arr[i - 1].p;
+        if (PolyIsCoeff(coeff)) {
+            Emit(c, OP_ADD_CONST, (unsigned long) coeff->coeff);
+        } else {
+            CompileAt(c, coeff, level + 1);
+            Emit(c, OP_ADD, 0);
+        }
+    }
+    if (p->arr[0].exp > 0)
+        Emit(c, OP_MUL_POWER, RequestPower(c, level, p->arr[0].exp));
+}
+
+/**
+ * To jest struktura wiążąca żądaną potęgę z jej tymczasowym indeksem.
+ */
+typedef struct PowerRequest {
+    size_t var; ///< indeks zmiennej
+    poly_exp_t exp; ///< wykładnik
+    size_t index; ///< tymczasowy indeks potęgi
+} PowerRequest;
+
+/**
+ * Komparator żądań potęg względem zmiennej i wykładnika.
+ * @param[in] a : żądanie
+ * @param[in] b : żądanie
+ * @return liczba ujemna, zero lub liczba dodatnia, jeśli pierwsze żądanie jest odpowiednio mniejsze, równe lub większe
+ */
+static int PowerRequestCmp(const void *a, const void *b) {
+    const PowerRequest *x = (const PowerRequest *) a, *y = (const PowerRequest *) b;
+    if (x->var != y->var)
+        return x->var < y->var ? -1 : 1;
+    return (x->exp > y->exp) - (x->exp < y->exp);
+}
+
+PolyProgram *PolyCompile(const Poly *p, size_t nvars) {
+    assert(p != NULL);
+    Compiler c = {.nvars = nvars, .code = NULL, .length = 0, .capacity = 0, .powers = NULL,
+                  .power_count = 0, .power_capacity = 0, .depth = 0, .max_depth = 0};
+    CompileAt(&c, p, 0);
+
+    //Usuwamy powtórzenia potęg i układamy je tak, żeby można je było liczyć przyrostowo.
+    PowerRequest *requests = (PowerRequest *) SafeMalloc((c.power_count + 1) * sizeof(PowerRequest));
+    for (size_t i = 0; i < c.power_count; i++)
+        requests[i] = (PowerRequest) {.var = c.powers[i].var, .exp = c.powers[i].exp, .index = i};
+    qsort(requests, c.power_count, sizeof(PowerRequest), PowerRequestCmp);
+
+    size_t *remap = (size_t *) SafeMalloc((c.power_count + 1) * sizeof(size_t));
+    PolyProgram *program = (PolyProgram *) SafeMalloc(sizeof(PolyProgram));
+    program->powers = (PowerStep *) SafeMalloc((c.power_count + 1) * sizeof(PowerStep));
+    program->power_count = 0;
+    for (size_t i = 0; i < c.power_count; i++) {
+        PowerStep *last = program->power_count > 0 ? &program->powers[program->power_count - 1] : NULL;
+        if (last == NULL || last->var != requests[i].var || last->exp != requests[i].exp) {
+            bool chained = last != NULL && last->var == requests[i].var;
+            program->powers[program->power_count++] = (PowerStep) {
+                .var = requests[i].var,
+                .exp = requests[i].exp,
+                .step = chained ? requests[i].exp - last->exp : requests[i].exp,
+                .chained = chained
+            };
+        }
+        remap[requests[i].index] = program->power_count - 1;
+    }
+    for (size_t i = 0; i < c.length; i++) {
+        if (c.code[i].op == OP_MUL_POWER)
+            c.code[i].arg = remap[c.code[i].arg];
+    }
+
+    program->code = c.code;
+    program->length = c.length;
+    program->depth = c.max_depth;
+    free(remap);
+    free(requests);
+    free(c.powers);
+    return program;
+}
+
+/**
+ * Podnosi liczbę do potęgi modulo @f$2^{64}@f$.
+ * @param[in] a : podstawa
+ * @param[in] n : wykładnik
+ * @return @f$a^n@f$
+ */
+static unsigned long Power(unsigned long a, poly_exp_t n) {
+    unsigned long acc = 1;
+    while (n > 0) {
+        if (n % 2 == 1)
+            acc *= a;
+        a *= a;
+        n /= 2;
+    }
+    return acc;
+}
+
+poly_coeff_t PolyProgramEval(const PolyProgram *program, const poly_coeff_t x[]) {
+    assert(program != NULL);
+    unsigned long local[PROGRAM_LOCAL_SLOTS];
+    size_t needed = program->power_count + program->depth;
+    unsigned long *memory = needed <= PROGRAM_LOCAL_SLOTS ? local : (unsigned long *) SafeMalloc(needed * sizeof(unsigned long));
+    unsigned long *power = memory, *stack = memory + program->power_count;
+
+    for (size_t i = 0; i < program->power_count; i++) {
+        const PowerStep *step = &program->powers[i];
+        unsigned long value = Power((unsigned long) x[step->var], step->step);
+        power[i] = step->chained ? power[i - 1] * value : value;
+    }
+
+    size_t top = 0;
+    for (size_t i = 0; i < program->length; i++) {
+        const Instruction *instruction = &program->code[i];
+        switch (instruction->op) {
+            case OP_PUSH:
+                stack[top++] = instruction->arg;
+                break;
+            case OP_ADD_CONST:
+                stack[top - 1] += instruction->arg;
+                break;
+            case OP_ADD:
+                top--;
+                stack[top - 1] += stack[top];
+                break;
+            case OP_MUL_POWER:
+                stack[top - 1] *= power[instruction->arg];
+                break;
+        }
+    }
+
+    poly_coeff_t result = (poly_coeff_t) stack[0];
+    if (memory != local)
+        free(memory);
+    return result;
+}
+
+void PolyProgramFree(PolyProgram *program) {
+    if (program == NULL)
+        return;
+    free(program->code);
+    free(program->powers);
+    free(program);
+}
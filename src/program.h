@@ -0,0 +1,51 @@
+/** @file
+  Interfejs programów wyliczających wartości wielomianów.
+
+  Wielomian jest tłumaczony funkcją PolyCompile na płaski program dla
+  maszyny stosowej, realizujący schemat Hornera względem każdej zmiennej.
+  Potrzebne potęgi zmiennych są wyliczane raz na początku każdego wykonania,
+  przyrostowo, od najmniejszego wykładnika danej zmiennej.
+  Wykonanie programu nie odwołuje się do drzewa jednomianów.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include "poly.h"
+
+/**
+ * To jest struktura przechowująca skompilowany program.
+ */
+typedef struct PolyProgram PolyProgram;
+
+/**
+ * Tłumaczy wielomian na program wyliczający jego wartość po podstawieniu
+ * liczb za zmienne @f$x_0, \ldots, x_{nvars - 1}@f$. Za pozostałe zmienne
+ * podstawiane jest zero, tak jak w PolyEvalPoint.
+ * Program nie odwołuje się do wielomianu, który może być potem usunięty.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] nvars : liczba zmiennych
+ * @return program
+ */
+PolyProgram *PolyCompile(const Poly *p, size_t nvars);
+
+/**
+ * Wykonuje program, wyliczając wartość wielomianu w punkcie.
+ * Wynik jest równy wynikowi PolyEvalPoint dla tego samego wielomianu.
+ * @param[in] program : program
+ * @param[in] x : tablica wartości zmiennych, o długości podanej w PolyCompile
+ * @return @f$p(x_0, x_1, \ldots)@f$
+ */
+poly_coeff_t PolyProgramEval(const PolyProgram *program, const poly_coeff_t x[]);
+
+/**
+ * Zwalnia pamięć programu.
+ * @param[in] program : program lub NULL
+ */
+void PolyProgramFree(PolyProgram *program);
+
+#endif //PROGRAM_H
@@ -0,0 +1,144 @@
+/** @file
+  Implementacja modułu wczytującego wejście wierszami.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+//To jest makro potrzebne do działania funkcji read, fstat i mmap.
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "reader.h"
+#include "memory.h"
+
+/** Wielkość bloku wczytywanego jednym wywołaniem read. */
+#define READER_CHUNK (1 << 20)
+
+/**
+ * Szuka pierwszego znaku '\0' w nieprzetworzonych danych od zadanej pozycji.
+ * @param[in] r : stan wczytywania
+ * @param[in] from : pozycja początkowa
+ * @return pozycja znaku lub koniec danych, jeśli go nie ma
+ */
+static size_t FindNul(const Reader *r, size_t from) {
+    const char *nul = memchr(r->buffer + from, '\0', r->end - from);
+    return nul == NULL ? r->end : (size_t) (nul - r->buffer);
+}
+
+void ReaderOpen(Reader *r, int fd, bool map) {
+    *r = (Reader) {.fd = fd, .buffer = NULL, .capacity = 0, .begin = 0, .end = 0, .nul = 0,
+                   .patched = 0, .saved = '\0', .has_saved = false, .eof = false, .mapped = false,
+                   .tail = NULL};
+
+    struct stat st;
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (map && offset >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > offset) {
+        //Odwzorowanie prywatne pozwala wpisywać znaki '\0' za wierszami bez zmieniania pliku.
+        void *data = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            posix_madvise(data, (size_t) st.st_size, POSIX_MADV_SEQUENTIAL);
+            r->buffer = data;
+            r->capacity = r->end = (size_t) st.st_size;
+            r->begin = (size_t) offset;
+            r->nul = FindNul(r, r->begin);
+            r->eof = r->mapped = true;
+            return;
+        }
+    }
+
+    r->capacity = READER_CHUNK;
+    r->buffer = (char *) SafeMalloc(r->capacity);
+}
+
+/**
+ * Przesuwa nieprzetworzone dane na początek bufora i dowczytuje za nimi
+ * kolejny blok wejścia, w razie potrzeby powiększając bufor.
+ * @param[in,out] r : stan wczytywania
+ */
+static void Refill(Reader *r) {
+    if (r->nul < r->begin)
+        r->nul = FindNul(r, r->begin);
+    bool found = r->nul < r->end;
+    memmove(r->buffer, r->buffer + r->begin, r->end - r->begin);
+    r->end -= r->begin;
+    r->nul -= r->begin;
+    r->begin = 0;
+
+    //Jeden bajt bufora jest zawsze wolny na znak '\0' za ostatnim wierszem.
+    while (r->capacity - r->end <= READER_CHUNK / 2)
+        r->capacity *= 2;
+    r->buffer = (char *) SafeRealloc(r->buffer, r->capacity);
+
+    ssize_t count;
+    do {
+        count = read(r->fd, r->buffer + r->end, r->capacity - r->end - 1);
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) {
+        r->eof = true;
+        return;
+    }
+    size_t old_end = r->end;
+    r->end += (size_t) count;
+    if (!found)
+        r->nul = FindNul(r, old_end);
+}
+
+bool ReaderNext(Reader *r, ReaderLine *line) {
+    if (r->has_saved) {
+        r->buffer[r->patched] = r->saved;
+        r->has_saved = false;
+    }
+    free(r->tail);
+    r->tail = NULL;
+
+    //Przy dowczytywaniu nie przeszukujemy ponownie już sprawdzonej części wiersza.
+    size_t scanned = r->begin;
+    const char *newline;
+    while ((newline = memchr(r->buffer + scanned, '\n', r->end - scanned)) == NULL && !r->eof) {
+        scanned = r->end - r->begin;
+        Refill(r);
+        scanned += r->begin;
+    }
+    if (newline == NULL && r->begin == r->end)
+        return false;
+
+    size_t line_end = newline == NULL ? r->end : (size_t) (newline - r->buffer) + 1;
+    if (r->nul < r->begin)
+        r->nul = FindNul(r, r->begin);
+    line->has_nul = r->nul < line_end;
+    line->length = line_end - r->begin;
+
+    if (r->mapped && line_end == r->end) {
+        //Za końcem odwzorowanego pliku może nie być już pamięci na znak '\0'.
+        r->tail = (char *) SafeMalloc(line->length + 1);
+        memcpy(r->tail, r->buffer + r->begin, line->length);
+        r->tail[line->length] = '\0';
+        line->text = r->tail;
+    } else {
+        if (line_end < r->end) {
+            r->saved = r->buffer[line_end];
+            r->patched = line_end;
+            r->has_saved = true;
+        }
+        r->buffer[line_end] = '\0';
+        line->text = r->buffer + r->begin;
+    }
+    r->begin = line_end;
+    return true;
+}
+
+void ReaderClose(Reader *r) {
+    if (r->mapped)
+        munmap(r->buffer, r->capacity);
+    else
+        free(r->buffer);
+    free(r->tail);
+    r->buffer = r->tail = NULL;
+}
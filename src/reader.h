@@ -0,0 +1,72 @@
+/** @file
+  Interfejs modułu wczytującego wejście wierszami.
+
+  Wejście jest wczytywane dużymi blokami do jednego bufora, a wiersze są
+  wyszukiwane w nim funkcją memchr i oddawane bez kopiowania: za wierszem
+  wpisywany jest znak '\0', a zasłonięty nim znak jest przywracany przy
+  pobraniu następnego wiersza. Zwykły plik może być zamiast tego odwzorowany
+  w pamięci w całości.
+
+  @author Daniel Mastalerz
+  @copyright Uniwersytet Warszawski
+  @date 2021
+*/
+
+#ifndef READER_H
+#define READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * To jest struktura przechowująca stan wczytywania.
+ */
+typedef struct Reader {
+    int fd; ///< deskryptor wejścia
+    char *buffer; ///< bufor z danymi lub odwzorowany plik
+    size_t capacity; ///< pojemność bufora
+    size_t begin; ///< początek nieprzetworzonych danych
+    size_t end; ///< koniec wczytanych danych
+    size_t nul; ///< pierwszy znak '\0' w danych, nie wcześniej niż wiersz, w którym wystąpił, lub end
+    size_t patched; ///< pozycja wpisanego znaku '\0', jeśli saved jest ważne
+    char saved; ///< znak zasłonięty przez wpisany znak '\0'
+    bool has_saved; ///< czy trzeba przywrócić zasłonięty znak
+    bool eof; ///< czy wejście się skończyło
+    bool mapped; ///< czy bufor jest odwzorowanym plikiem
+    char *tail; ///< kopia ostatniego wiersza odwzorowanego pliku
+} Reader;
+
+/**
+ * To jest struktura opisująca wczytany wiersz.
+ */
+typedef struct ReaderLine {
+    char *text; ///< wiersz zakończony znakiem '\0', ważny do pobrania następnego wiersza
+    size_t length; ///< długość wiersza razem ze znakiem nowej linii, jeśli go ma
+    bool has_nul; ///< czy wiersz zawiera znak '\0'
+} ReaderLine;
+
+/**
+ * Rozpoczyna wczytywanie wejścia od bieżącej pozycji.
+ * @param[out] r : stan wczytywania
+ * @param[in] fd : deskryptor wejścia
+ * @param[in] map : czy odwzorować wejście w pamięci, jeśli jest zwykłym plikiem
+ */
+void ReaderOpen(Reader *r, int fd, bool map);
+
+/**
+ * Pobiera następny wiersz wejścia. Wiersz kończy się znakiem nowej linii,
+ * chyba że jest ostatnim wierszem wejścia. W przypadku braku pamięci kończy
+ * program z kodem 1.
+ * @param[in,out] r : stan wczytywania
+ * @param[out] line : wiersz
+ * @return czy wczytano wiersz, fałsz po zakończeniu wejścia
+ */
+bool ReaderNext(Reader *r, ReaderLine *line);
+
+/**
+ * Kończy wczytywanie i zwalnia pamięć. Nie zamyka deskryptora.
+ * @param[in,out] r : stan wczytywania
+ */
+void ReaderClose(Reader *r);
+
+#endif //READER_H
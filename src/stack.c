@@ -10,36 +10,164 @@
 #include "poly.h"
 #include "stack.h"
 #include "memory.h"
+#include "intern.h"
 
 Stack NewStack() {
     Poly *arr = (Poly *) SafeMalloc(sizeof(Poly));
-    Stack s = (Stack) {.size = 0, .capacity = 1, .arr = arr};
+    Arena **arenas = (Arena **) SafeMalloc(sizeof(Arena *));
+    LazyNode **nodes = (LazyNode **) SafeMalloc(sizeof(LazyNode *));
+    Stack s = (Stack) {.size = 0, .capacity = 1, .arr = arr, .arenas = arenas, .use_arenas = false, .pending = NULL, .intern = false,
+                       .nodes = nodes, .lazy = false};
     return s;
 }
 
-void StackAdd(Stack *stack, Poly p) {
+void StackBeginResult(Stack *stack) {
+    if (!stack->use_arenas)
+        return;
+    stack->pending = ArenaNew();
+    ArenaUse(stack->pending);
+}
+
+void StackCancelResult(Stack *stack) {
+    if (stack->pending == NULL)
+        return;
+    ArenaUse(NULL);
+    ArenaDestroy(stack->pending);
+    stack->pending = NULL;
+}
+
+/**
+ * Zapewnia miejsce na kolejny element stosu.
+ * @param[in] stack : stos
+ */
+static void StackReserve(Stack *stack) {
     if (stack->size >= stack->capacity) {
         stack->capacity *= 2;
         stack->arr = SafeRealloc(stack->arr, stack->capacity * sizeof(Poly));
+        stack->arenas = SafeRealloc(stack->arenas, stack->capacity * sizeof(Arena *));
+        stack->nodes = SafeRealloc(stack->nodes, stack->capacity * sizeof(LazyNode *));
+    }
+}
+
+void StackAdd(Stack *stack, Poly p) {
+    StackReserve(stack);
+    if (stack->intern)
+        p = PolyIntern(&p);
+    if (stack->pending != NULL) {
+        ArenaUse(NULL);
+        //Współczynnik nie zajmuje bloków, więc arena wyniku nie jest mu potrzebna.
+        if (PolyIsCoeff(&p)) {
+            ArenaDestroy(stack->pending);
+            stack->pending = NULL;
+        }
     }
     stack->arr[stack->size] = p;
+    stack->arenas[stack->size] = stack->pending;
+    stack->nodes[stack->size] = NULL;
+    stack->size++;
+    stack->pending = NULL;
+}
+
+/**
+ * Zdejmuje element ze szczytu stosu jako węzeł wyrażenia.
+ * @param[in] stack : stos
+ * @return węzeł elementu
+ */
+static LazyNode *StackTakeNode(Stack *stack) {
+    stack->size--;
+    LazyNode *node = stack->nodes[stack->size];
+    return node != NULL ? node : LazyFromPoly(stack->arr[stack->size]);
+}
+
+/**
+ * Wstawia węzeł wyrażenia na szczyt stosu.
+ * @param[in] stack : stos
+ * @param[in] node : węzeł
+ */
+static void StackAddNode(Stack *stack, LazyNode *node) {
+    StackReserve(stack);
+    stack->arr[stack->size] = PolyZero();
+    stack->arenas[stack->size] = NULL;
+    stack->nodes[stack->size] = node;
     stack->size++;
 }
 
+bool StackDefer(Stack *stack, LazyKind kind) {
+    assert(kind != LAZY_VALUE);
+    if (!stack->lazy || stack->use_arenas)
+        return false;
+    LazyNode *p = StackTakeNode(stack);
+    if (kind == LAZY_NEG) {
+        StackAddNode(stack, LazyNeg(p));
+    } else {
+        LazyNode *q = StackTakeNode(stack);
+        StackAddNode(stack, LazyBinary(kind, p, q));
+    }
+    return true;
+}
+
+bool StackDeferClone(Stack *stack) {
+    if (!stack->lazy || stack->use_arenas)
+        return false;
+    LazyNode *node = StackTakeNode(stack);
+    StackAddNode(stack, node);
+    StackAddNode(stack, LazyShare(node));
+    return true;
+}
+
+void StackForceTop(Stack *stack, size_t count) {
+    for (size_t i = stack->size; i > 0 && stack->size - i < count; i--) {
+        LazyNode *node = stack->nodes[i - 1];
+        if (node == NULL)
+            continue;
+        Poly p = LazyTake(node);
+        stack->arr[i - 1] = stack->intern ? PolyIntern(&p) : p;
+        stack->nodes[i - 1] = NULL;
+    }
+}
+
 Poly StackTop(Stack *stack) {
+    StackForceTop(stack, 1);
     return stack->arr[stack->size - 1];
 }
 
 void StackPop(Stack *stack) {
     if (stack->size == 0) return;
+    StackForceTop(stack, 1);
     stack->size--;
 }
 
+Poly StackTake(Stack *stack) {
+    assert(stack->pending == NULL);
+    StackForceTop(stack, 1);
+    stack->size--;
+    //Wynik powstaje w miejscu elementu, więc jego arena przechodzi na wynik.
+    stack->pending = stack->arenas[stack->size];
+    if (stack->pending != NULL)
+        ArenaUse(stack->pending);
+    return stack->arr[stack->size];
+}
+
+void StackDrop(Stack *stack) {
+    if (stack->size == 0) return;
+    stack->size--;
+    //Niewyliczony element zwalniamy bez liczenia jego wartości.
+    if (stack->nodes[stack->size] != NULL)
+        LazyRelease(stack->nodes[stack->size]);
+    //Wielomian z areny zwalniamy w czasie stałym, razem z całą areną.
+    else if (stack->arenas[stack->size] != NULL)
+        ArenaDestroy(stack->arenas[stack->size]);
+    else
+        PolyDestroy(&stack->arr[stack->size]);
+}
+
 void StackDestroy(Stack *stack) {
-    for (size_t i = 0; i < stack->size; i++) {
-        PolyDestroy(&stack->arr[i]);
-    }
+    StackCancelResult(stack);
+    while (stack->size > 0)
+        StackDrop(stack);
     free(stack->arr);
+    free(stack->arenas);
+    free(stack->nodes);
 }
 
 
@@ -9,17 +9,31 @@
 #ifndef STACK_H
 #define STACK_H
 
+#include <stdbool.h>
 #include "poly.h"
+#include "memory.h"
+#include "lazy.h"
 
 /**
  * To jest struktura przechowująca stos.
  * Stos ma obecny rozmiar, pojemność oraz tablicę wielomianów.
  * Element na szczycie stostu to element tablicy o indeksie size - 1.
+ * W trybie aren każdy wynik operacji jest budowany we własnej arenie,
+ * zwalnianej w całości razem z elementem stosu.
+ * W trybie leniwym wyniki operacji są węzłami wyrażeń, wyliczanymi dopiero
+ * wtedy, gdy potrzebny jest wielomian; do tego czasu element tablicy
+ * wielomianów jest nieużywany.
  */
 typedef struct Stack {
     size_t size; ///< rozmiar stosu
     size_t capacity; ///< pojemność stosu
     Poly* arr; ///< tablica, w której przechowywane są elementy stosu
+    Arena** arenas; ///< areny, z których pochodzą elementy stosu, lub NULL dla elementów ze sterty
+    bool use_arenas; ///< czy wyniki operacji są budowane w arenach
+    Arena* pending; ///< arena budowanego wyniku operacji lub NULL
+    bool intern; ///< czy elementy stosu są sprowadzane do postaci kanonicznej funkcją PolyIntern
+    LazyNode** nodes; ///< niewyliczone węzły elementów stosu lub NULL dla elementów wyliczonych
+    bool lazy; ///< czy operacje są odkładane do czasu, gdy potrzebny jest wynik
 } Stack;
 
 /**
@@ -29,14 +43,58 @@ typedef struct Stack {
 Stack NewStack();
 
 /**
- * Wstawia element na szczyt stosu.
+ * Wstawia element na szczyt stosu. Jeśli włączone jest pole intern,
+ * element jest najpierw zamieniany funkcją PolyIntern. Współczynnik jest
+ * wstawiany bez areny, a arena rozpoczęta dla niego przez StackBeginResult
+ * jest zwalniana.
  * @param[in] stack : stos
  * @param[in] p : wielomian
  */
 void StackAdd(Stack* stack, Poly p);
 
 /**
- * Zwraca element ze szczytu stosu.
+ * Rozpoczyna budowanie wyniku operacji. W trybie aren tworzy nową arenę
+ * i ustawia ją jako bieżącą, a najbliższe wywołanie StackAdd wstawi wynik razem z nią.
+ * @param[in] stack : stos
+ */
+void StackBeginResult(Stack* stack);
+
+/**
+ * Porzuca budowanie wyniku operacji rozpoczęte przez StackBeginResult,
+ * zwalniając jego arenę.
+ * @param[in] stack : stos
+ */
+void StackCancelResult(Stack* stack);
+
+/**
+ * W trybie leniwym zastępuje elementy ze szczytu stosu węzłem operacji
+ * o rodzaju @p kind, którego argumentami są: element ze szczytu stosu
+ * i, dla operacji dwuargumentowych, element pod nim.
+ * Tryb leniwy nie działa razem z trybem aren.
+ * @param[in] stack : stos
+ * @param[in] kind : rodzaj operacji, różny od LAZY_VALUE
+ * @return czy operacja została odłożona; jeśli nie, wołający musi ją wykonać
+ */
+bool StackDefer(Stack* stack, LazyKind kind);
+
+/**
+ * W trybie leniwym wstawia na stos kopię elementu ze szczytu stosu,
+ * współdzielącą z nim węzeł, więc wartość zostanie wyliczona co najwyżej raz.
+ * @param[in] stack : stos
+ * @return czy kopia została wstawiona; jeśli nie, wołający musi ją wstawić
+ */
+bool StackDeferClone(Stack* stack);
+
+/**
+ * Wylicza niewyliczone elementy spośród @p count elementów ze szczytu stosu,
+ * po czym można je czytać bezpośrednio z tablicy wielomianów.
+ * @param[in] stack : stos
+ * @param[in] count : liczba elementów
+ */
+void StackForceTop(Stack* stack, size_t count);
+
+/**
+ * Zwraca element ze szczytu stosu, w trybie leniwym najpierw go wyliczając.
  * @param[in] stack: stos
  * @return wielomian ze szczytu stosu.
  */
@@ -48,6 +106,24 @@ Poly StackTop(Stack* stack);
  */
 void StackPop(Stack* stack);
 
+/**
+ * Zdejmuje element ze szczytu stosu i przekazuje go na własność wołającemu,
+ * który zbuduje z niego wynik w miejscu. W trybie aren arena elementu staje się
+ * bieżącą areną i areną wyniku, którą najbliższe wywołanie StackAdd wstawi
+ * razem z nim, więc w tym trybie nie wolno jej wołać po StackBeginResult ani
+ * dwa razy przed StackAdd. Operacje budujące wynik od nowa powinny zamiast
+ * tego użyć StackDrop, żeby arena elementu została zwolniona.
+ * @param[in] stack: stos
+ * @return wielomian ze szczytu stosu.
+ */
+Poly StackTake(Stack* stack);
+
+/**
+ * Usuwa element ze szczytu stosu i zwalnia jego pamięć.
+ * @param[in] stack: stos
+ */
+void StackDrop(Stack* stack);
+
 /**
  * Zwalnia pamięć przeznaczoną na stos, wraz z wielomianami znajdującymi się na stosie.
  * @param[in] stack: stos